@@ -0,0 +1,39 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include "Histogram.h"
+
+// Running mean/variance (Welford), numerically stable in one pass
+struct Welford {
+    double n=0, mean=0, m2=0;
+    void add(double x){ n++; double d=x-mean; mean+=d/n; m2+=d*(x-mean); }
+    double var() const { return n>1 ? m2/(n-1) : 0; }
+};
+
+// One metric compared between variant 0 (A) and 1 (B), which alternate in blocks
+// of frames. Each block's mean is one observation, so correlation between
+// neighbouring frames (same scene, same clocks) doesn't shrink the interval;
+// blocks of A and B interleave, so slow drift (thermals) hits both alike.
+// Per-frame values also go into a histogram per variant for percentiles.
+// Written by the render thread only.
+struct AbMetric {
+    Welford blocks[2];
+    Histogram frames[2];
+    unsigned block=~0u; int variant=0; double sum=0; int n=0;
+
+    void add(int v, unsigned blk, uint64_t ns){
+        if(blk!=block){ close(); block=blk; variant=v; }
+        sum+=ns; n++; frames[v].record(ns);
+    }
+    void close(){ if(n) blocks[variant].add(sum/n); sum=0; n=0; }
+    void reset(){ blocks[0]=blocks[1]=Welford(); frames[0].reset(); frames[1].reset(); block=~0u; sum=0; n=0; }
+
+    // Mean of B minus mean of A, with a 95% interval (Welch, normal approximation:
+    // trust it from ~10 blocks per variant)
+    bool diff(double& d, double& ci) const {
+        const Welford &a=blocks[0], &b=blocks[1];
+        if(a.n<2 || b.n<2) return false;
+        d=b.mean-a.mean; ci=1.96*sqrt(a.var()/a.n+b.var()/b.n);
+        return true;
+    }
+};
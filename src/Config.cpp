@@ -0,0 +1,84 @@
+#include "Config.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+Seqlock<Config> config;
+pthread_mutex_t configWrite = PTHREAD_MUTEX_INITIALIZER;
+Seqlock<AbConfig> abConfig;
+
+// preset = name applies a bundle of keys; later lines can still override them
+static const char* PRESETS[][2] = {
+    {"performance","checkerboard=1 fovea_levels=3 ring=2"},
+    {"balanced","checkerboard=0 fovea_levels=2 ring=2"},
+    {"quality","checkerboard=0 fovea_levels=1 ring=3"},
+};
+
+bool applyKeys(Config& c, const char* kv){
+    char buf[128], *sp; snprintf(buf,sizeof(buf),"%s",kv);
+    bool ok=true;
+    for(char* t=strtok_r(buf," ",&sp);t;t=strtok_r(0," ",&sp)){ char* e=strchr(t,'='); if(e){ *e=0; ok&=setKey(c,t,e+1); } else ok=false; }
+    return ok;
+}
+
+// Index of v among an enum key's names (in enum order), -1 if it is none of them
+template<int N> static int pick(const char* v, const char* const (&names)[N]){
+    for(int i=0;i<N;i++) if(!strcmp(v,names[i])) return i;
+    return -1;
+}
+static const char* const MASK_NAMES[] = {"none","ellipse","circle"};
+static const char* const TRACE_NAMES[] = {"0","1","json"};
+
+bool setKey(Config& c, const char* k, const char* v){
+    if(!strcmp(k,"mask")){ int m=pick(v,MASK_NAMES); if(m<0) return false; c.maskShape=m; }
+    else if(!strcmp(k,"mask_inner")) c.maskInner=strtof(v,0);
+    else if(!strcmp(k,"mask_outer")) c.maskOuter=strtof(v,0);
+    else if(!strcmp(k,"ring")) c.ring=atoi(v)>=3?3:2;
+    else if(!strcmp(k,"checkerboard")) c.checkerboard=atoi(v)!=0;
+    else if(!strcmp(k,"fovea_levels")) c.foveaLevels=atoi(v);
+    else if(!strcmp(k,"fovea_size")) c.foveaSize=fminf(fmaxf(strtof(v,0),0.1f),1.0f);
+    else if(!strcmp(k,"trace")){ int t=pick(v,TRACE_NAMES); if(t<0) return false; c.trace=t; }
+    else if(!strcmp(k,"dump_seconds")) c.dumpSeconds=atoi(v)<0?0:atoi(v)>10?10:atoi(v);
+    else if(!strcmp(k,"scale")) c.scale=fminf(fmaxf(strtof(v,0),0.25f),1.0f);
+    else if(!strcmp(k,"sharpen")) c.sharpen=fminf(fmaxf(strtof(v,0),0.0f),1.0f);
+    else if(!strcmp(k,"governor")) c.governor=atoi(v)!=0;
+    else if(!strcmp(k,"sysfs_root")) snprintf(c.sysfsRoot,sizeof(c.sysfsRoot),"%s",v);
+    else if(!strcmp(k,"preset")){
+        for(auto& p:PRESETS) if(!strcmp(v,p[0])) return applyKeys(c,p[1]);
+        return false;
+    }
+    else return false;
+    return true;
+}
+
+bool getKey(const Config& c, const char* k, char* v, size_t n){
+    if(!strcmp(k,"mask")) snprintf(v,n,"%s",MASK_NAMES[c.maskShape]);
+    else if(!strcmp(k,"mask_inner")) snprintf(v,n,"%g",c.maskInner);
+    else if(!strcmp(k,"mask_outer")) snprintf(v,n,"%g",c.maskOuter);
+    else if(!strcmp(k,"ring")) snprintf(v,n,"%d",c.ring);
+    else if(!strcmp(k,"checkerboard")) snprintf(v,n,"%d",c.checkerboard);
+    else if(!strcmp(k,"fovea_levels")) snprintf(v,n,"%d",c.foveaLevels);
+    else if(!strcmp(k,"fovea_size")) snprintf(v,n,"%g",c.foveaSize);
+    else if(!strcmp(k,"trace")) snprintf(v,n,"%s",TRACE_NAMES[c.trace]);
+    else if(!strcmp(k,"dump_seconds")) snprintf(v,n,"%d",c.dumpSeconds);
+    else if(!strcmp(k,"scale")) snprintf(v,n,"%g",c.scale);
+    else if(!strcmp(k,"sharpen")) snprintf(v,n,"%g",c.sharpen);
+    else if(!strcmp(k,"governor")) snprintf(v,n,"%d",c.governor);
+    else if(!strcmp(k,"sysfs_root")) snprintf(v,n,"%s",c.sysfsRoot);
+    else return false;
+    return true;
+}
+
+bool sameTextures(const Config& a, const Config& b){
+    return a.foveaLevels==b.foveaLevels && a.checkerboard==b.checkerboard && a.ring==b.ring && a.scale==b.scale;
+}
+bool sameResources(const Config& a, const Config& b){ return sameTextures(a,b) && (a.sharpen>0)==(b.sharpen>0); }
+
+bool loadConfig(const char* path, Config& c){
+    FILE* f=fopen(path,"r"); if(!f) return false;
+    char line[256], k[64], v[128];
+    while(fgets(line,sizeof(line),f)) if(line[0]!='#' && sscanf(line," %63[^= ] = %127s",k,v)==2) setKey(c,k,v);
+    fclose(f);
+    return true;
+}
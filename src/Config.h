@@ -0,0 +1,64 @@
+#pragma once
+#include <pthread.h>
+#include <cstddef>
+#include "Seqlock.h"
+
+// =============================================================
+// 1. FINAL SETTINGS
+// =============================================================
+static const float SCALE = 0.5f;          // 50% Internal Resolution (Max Performance), default of 'scale'
+static const float MAX_BLUR = 0.94f;      // 94% Smoothness (Walking/Looking around)
+static const float MIN_BLUR = 0.35f;      // 35% Smoothness (Fast PvP Flicks)
+static const float SHARPEN = 0.88f;       // 88% CAS Sharpening (HD Clarity), default of 'sharpen'
+static const float GAME_SCALE = 1.0f;     // 100% Game Resolution (<1.0 renders the game itself smaller and upscales it)
+static const bool SCENE_CAPTURE = false;  // Process the world before the HUD is drawn (no centre mask needed)
+static const bool UI_MASK = true;         // Learn static HUD pixels and keep them out of blur/sharpen
+static const int MASK_DIV = 8;            // UI mask resolution (1/8 of internal)
+static const int MASK_FRAMES = 60;        // Frames a pixel must stay identical to count as HUD
+static const float MASK_MOTION = 0.05f;   // ...while at least this fraction of the screen changes (a static scene teaches nothing)
+static const int DECAY_FRAMES = 90;       // 0.94^90 < 1/255: older damage has fully settled in the history
+
+// Runtime settings (CONFIG_PATH, re-read when it changes). key = value per line.
+enum MaskShape { MASK_NONE, MASK_ELLIPSE, MASK_CIRCLE };
+struct Config {
+    int maskShape = MASK_ELLIPSE;   // mask = none | ellipse (stretched with the screen) | circle
+    float maskInner = 0.01f;        // mask_inner: fully protected radius (screen height units for circle)
+    float maskOuter = 0.12f;        // mask_outer: radius where the blur is back to full strength
+    bool checkerboard = false;      // checkerboard: blur half the pixels per frame (low-end GPUs)
+    int ring = 2;                   // ring: capture/history textures in rotation (3 = never write what the GPU may still read)
+    int foveaLevels = 1;            // fovea_levels: 1 = off, 2-3 = outer rings at 1/2, 1/4 resolution
+    float foveaSize = 0.6f;         // fovea_size: each ring's inner edge as a fraction of its outer edge
+    int trace = 0;                  // trace: 0 | 1 (binary, TRACE_PATH) | json (Perfetto, TRACE_JSON_PATH)
+    int dumpSeconds = 0;            // dump_seconds: keep this many seconds of downscaled captures for 'dump' (0 = off)
+    float scale = SCALE;            // scale: internal resolution of the blur (0.25-1)
+    float sharpen = SHARPEN;        // sharpen: CAS strength (0 = no sharpening pass at all)
+    bool governor = true;           // governor: step quality down when hot or low on battery (Governor.h)
+    char sysfsRoot[64] = "/sys";    // sysfs_root: where the governor reads thermal_zone* and power_supply
+};
+extern Seqlock<Config> config;
+extern pthread_mutex_t configWrite;   // held by every writer of config: file watcher, control socket, embedders
+
+// setKey: "preset" applies a bundle of keys. applyKeys: "k=v k=v ...", false if
+// any of them is not a valid setting. getKey: current value in the form setKey() takes.
+bool setKey(Config& c, const char* k, const char* v);
+bool applyKeys(Config& c, const char* kv);
+bool getKey(const Config& c, const char* k, char* v, size_t n);
+// True when a and b run on the same textures (fovea_levels, checkerboard, ring and
+// scale need new ones), and also on the same programs (sharpen on/off recompiles
+// the draw pass), so switching is free
+bool sameTextures(const Config& a, const Config& b);
+bool sameResources(const Config& a, const Config& b);
+bool loadConfig(const char* path, Config& c);
+inline const char* const CONFIG_KEYS[] = {"mask","mask_inner","mask_outer","ring","checkerboard","fovea_levels","fovea_size","trace","dump_seconds",
+                                          "scale","sharpen","governor","sysfs_root"};
+
+// A/B evaluation: two sets of keys applied on top of the config, alternating
+// every `every` frames (0 = off). Set with the control socket's 'ab' command.
+struct AbConfig { int every=0; char over[2][96]={}; };
+extern Seqlock<AbConfig> abConfig;
+// The first frames of each block aren't measured: AB_WARMUP when the flip is free,
+// AB_REBUILD_WARMUP when it rebuilds textures or the draw program (the rebuild
+// itself, the reseeded history and the relearned HUD mask stay out of the numbers).
+// A block must hold at least twice its warm-up.
+static const int AB_WARMUP = 8, AB_REBUILD_WARMUP = 30;
+inline int abWarmupFor(const Config& a, const Config& b){ return sameResources(a,b)?AB_WARMUP:AB_REBUILD_WARMUP; }
@@ -0,0 +1,127 @@
+#include "Control.h"
+#include "Config.h"
+#include "Recorder.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+bool controlAllowed(uid_t peer){ return peer==getuid() || peer==SHELL_UID; }
+
+static bool setDefault(const char* k, const char* v){
+    pthread_mutex_lock(&configWrite);
+    Config c=config.load(); bool ok=setKey(c,k,v);
+    if(ok) config.store(c);
+    pthread_mutex_unlock(&configWrite);
+    return ok;
+}
+
+// A whole token as a number in [lo,hi]: "5x", "" and "nan" are refused
+static bool intArg(const char* s, long lo, long hi, int& v){
+    char* e; errno=0; long x=strtol(s,&e,10);
+    if(e==s || *e || errno || x<lo || x>hi) return false;
+    v=(int)x; return true;
+}
+static bool numArg(const char* s, double lo, double hi, double& v){
+    char* e; double x=strtod(s,&e);
+    if(e==s || *e || !(x>=lo && x<=hi)) return false;
+    v=x; return true;
+}
+
+// ab N keys | keys: exactly one bar, each side trimmed and a valid set of keys
+static const long AB_EVERY_MAX = 1000000;
+static void abStart(int fd, const char* rest){
+    char* e; errno=0; long every=strtol(rest,&e,10);
+    const char* bar=strchr(e,'|');
+    if(e==rest || errno || every<2*AB_WARMUP || every>AB_EVERY_MAX || !strchr(" \t|",*e) || !bar || strchr(bar+1,'|')){
+        dprintf(fd,"err usage: ab frames(>=%d) keys | keys\n",2*AB_WARMUP); return;
+    }
+    AbConfig a; a.every=(int)every;
+    const char* side[2][2]={{e,bar},{bar+1,bar+1+strlen(bar+1)}};
+    for(int i=0;i<2;i++){
+        const char *b=side[i][0], *z=side[i][1];
+        while(b<z && strchr(" \t\r\n",*b)) b++;
+        while(z>b && strchr(" \t\r\n",z[-1])) z--;
+        if(z-b>=(long)sizeof(a.over[i])){ dprintf(fd,"err ab keys too long\n"); return; }
+        memcpy(a.over[i],b,z-b); a.over[i][z-b]=0;
+    }
+    Config test;
+    if(!applyKeys(test,a.over[0]) || !applyKeys(test,a.over[1])){ dprintf(fd,"err bad keys\n"); return; }
+    Config va=config.load(), vb=va; applyKeys(va,a.over[0]); applyKeys(vb,a.over[1]);
+    if(a.every<2*abWarmupFor(va,vb)){ dprintf(fd,"err ab variants that rebuild (fovea_levels, checkerboard, ring, scale, sharpen on/off) need frames >= %d\n",2*AB_REBUILD_WARMUP); return; }
+    abConfig.store(a); dprintf(fd,"ok\n");
+}
+
+void controlCommand(int fd, const char* line, const ControlHandlers& h){
+    char cmd[32]="", k[64]="", v[128]="", more[2]="", out[512];
+    int n=sscanf(line,"%31s %63s %127s %1s",cmd,k,v,more);   // tokens after the command, plus one to spot extras
+    if(n<1) return;
+    if(!strcmp(cmd,"get")){
+        if(n>2){ dprintf(fd,"err usage: get [key]\n"); return; }
+        Config c=config.load(); int m=snprintf(out,sizeof(out),"ok");
+        for(const char* key:CONFIG_KEYS) if(!k[0] || !strcmp(k,key)){ char val[64]; getKey(c,key,val,sizeof(val)); m+=snprintf(out+m,sizeof(out)-m," %s=%s",key,val); }
+        if(k[0] && m==2) dprintf(fd,"err unknown key %s\n",k); else dprintf(fd,"%s\n",out);
+    }
+    else if(!strcmp(cmd,"set") || !strcmp(cmd,"preset")){
+        bool preset=!strcmp(cmd,"preset");
+        if(n==(preset?2:3) && (h.set?h.set:setDefault)(preset?"preset":k,preset?k:v)) dprintf(fd,"ok\n");
+        else dprintf(fd,"err bad %s\n",cmd);
+    }
+    else if(!strcmp(cmd,"bench") && h.bench){
+        int sec;
+        if(n!=2 || !intArg(k,1,BENCH_MAX,sec)) dprintf(fd,"err usage: bench seconds(1-%d)\n",BENCH_MAX);
+        else h.bench(fd,sec);
+    }
+    else if(!strcmp(cmd,"dump-stats") && h.stats){
+        if(n!=1){ dprintf(fd,"err usage: dump-stats\n"); return; }
+        Stats s=h.stats();
+        dprintf(fd,"ok frames=%llu skipped=%llu fps=%.1f capture_ms=%.3f blur_ms=%.3f draw_ms=%.3f width=%d height=%d scale=%.2f game_scale=%.2f levels=%d ring=%d turns=%d texture_bytes=%llu path=%.*s flags=%u governor=%d temp=%.1f battery=%d\n",
+            (unsigned long long)s.frames,(unsigned long long)s.skipped,s.fps,s.passMs[0],s.passMs[1],s.passMs[2],s.width,s.height,s.scale,s.gameScale,
+            s.levels,s.ring,s.turns,(unsigned long long)s.textureBytes,(int)sizeof(s.capture),s.capture,s.flags,s.governor,s.temp,s.battery);
+    }
+    else if(!strcmp(cmd,"screenshot") && h.record){
+        if(n!=1){ dprintf(fd,"err usage: screenshot\n"); return; }
+        h.record(REC_PNG,1); dprintf(fd,"ok\n");
+    }
+    else if(!strcmp(cmd,"record") && h.record){
+        int frames=-1; double sec=0;
+        if(n>2 || (n==2 && strcmp(k,"stop") && (!numArg(k,0,RECORD_MAX,sec) || sec<=0))){ dprintf(fd,"err usage: record [seconds(<=%g)|stop]\n",RECORD_MAX); return; }
+        if(n==2 && !strcmp(k,"stop")) frames=0;
+        else if(n==2){ float fps=h.stats?h.stats().fps:0; frames=(int)(sec*(fps>1?fps:60)); if(frames<1) frames=1; }
+        h.record(REC_Y4M,frames); dprintf(fd,"ok\n");
+    }
+    else if(!strcmp(cmd,"dump") && h.dump){
+        if(n!=1) dprintf(fd,"err usage: dump\n");
+        else if(!h.dump()) dprintf(fd,"err dump_seconds is 0\n");
+        else dprintf(fd,"ok\n");
+    }
+    else if(!strcmp(cmd,"ab") && h.abReport){
+        if(n==1) h.abReport(fd);
+        else if(n==2 && !strcmp(k,"off")){ abConfig.store(AbConfig()); dprintf(fd,"ok\n"); }
+        else abStart(fd,line+strspn(line," \t")+2);   // the first token is exactly "ab"
+    }
+    else dprintf(fd,"err unknown command %s\n",cmd);
+}
+
+int controlListen(const char* name){
+    int s=socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+    sockaddr_un a={}; a.sun_family=AF_UNIX; strncpy(a.sun_path+1,name,sizeof(a.sun_path)-2);   // leading NUL: abstract namespace
+    socklen_t len=offsetof(sockaddr_un,sun_path)+1+strlen(a.sun_path+1);
+    if(s<0 || bind(s,(sockaddr*)&a,len)<0 || listen(s,4)<0){ if(s>=0) close(s); return -1; }
+    return s;
+}
+
+void controlServe(int s, const ControlHandlers& h){
+    for(;;){
+        int c=accept4(s,0,0,SOCK_CLOEXEC); if(c<0) continue;
+        ucred cr={}; socklen_t cl=sizeof(cr);
+        if(getsockopt(c,SOL_SOCKET,SO_PEERCRED,&cr,&cl)<0 || !controlAllowed(cr.uid)){ dprintf(c,"err not allowed\n"); close(c); continue; }
+        FILE* in=fdopen(c,"r"); char line[256];
+        while(in && fgets(line,sizeof(line),in)) controlCommand(c,line,h);
+        if(in) fclose(in); else close(c);
+    }
+}
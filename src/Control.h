@@ -0,0 +1,38 @@
+#pragma once
+#include <sys/types.h>
+#include "Stats.h"
+
+// =============================================================
+// CONTROL SOCKET: line commands on an abstract unix socket
+// =============================================================
+// One client at a time, one command per line, one reply line ("ok ..." or
+// "err ..."). The abstract namespace is open to every app on the device, so a
+// client must run as our own uid or as adb's shell (SO_PEERCRED); others get
+// "err not allowed" and are dropped before a command is read.
+static const uid_t SHELL_UID = 2000;
+bool controlAllowed(uid_t peer);
+
+// Every command is parsed and checked here: a malformed argument gets "err usage"
+// and nothing runs. get/set/preset/ab act on the config and A/B seqlocks; the
+// rest do the mod's work through these handlers, and a null one leaves its
+// command unknown.
+//   bench seconds          1..BENCH_MAX; the handler measures and replies
+//   dump-stats             stats() as key=value
+//   screenshot             record(REC_PNG, 1)
+//   record [seconds|stop]  record(REC_Y4M, frames): -1 until stopped, 0 stop, else seconds at stats().fps
+//   dump                   dump(); false: there is no ring (dump_seconds 0)
+//   ab | ab off | ab N keys | keys   abReport() for the first, the others store abConfig
+static const int BENCH_MAX = 9;            // the pacing histograms keep 10 one-second windows
+static const double RECORD_MAX = 600;      // seconds in one clip
+struct ControlHandlers {
+    bool (*set)(const char* k, const char* v);   // null: setKey under configWrite
+    void (*bench)(int fd, int seconds);
+    Stats (*stats)();
+    void (*record)(int kind, int frames);
+    bool (*dump)();
+    void (*abReport)(int fd);
+};
+
+int controlListen(const char* name);   // -1 if the socket can't be set up (name taken)
+void controlServe(int s, const ControlHandlers& h);   // accept loop, never returns
+void controlCommand(int fd, const char* line, const ControlHandlers& h);
@@ -0,0 +1,35 @@
+#include "FrameDump.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+
+DumpHeader* dumpOpen(const char* path, uint32_t slots, uint32_t maxSize){
+    uint32_t slotBytes=(uint32_t)(sizeof(DumpFrame)+(size_t)maxSize*maxSize*4);
+    size_t bytes=dumpBytes(slots,slotBytes);
+    int fd=open(path,O_RDWR|O_CREAT|O_TRUNC|O_CLOEXEC,0644);
+    if(fd<0) return 0;
+    void* p=ftruncate(fd,(off_t)bytes)==0 ? mmap(0,bytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0) : MAP_FAILED;
+    close(fd);
+    if(p==MAP_FAILED) return 0;
+    DumpHeader* h=(DumpHeader*)p;
+    memset(h,0,sizeof(DumpHeader));
+    memcpy(h->magic,"MBFD",4); h->version=DUMP_VERSION; h->slots=slots; h->slotBytes=slotBytes; h->maxSize=maxSize;
+    return h;
+}
+
+void dumpClose(DumpHeader* h){ if(h) munmap(h,dumpBytes(h->slots,h->slotBytes)); }
+
+bool dumpSave(const DumpHeader* h, const char* dir, char* path, size_t n){
+    uint32_t count=h->written<h->slots?h->written:h->slots;
+    if(!count) return false;
+    time_t now=time(0); char ts[32]; strftime(ts,sizeof(ts),"%Y%m%d-%H%M%S",localtime(&now));
+    snprintf(path,n,"%s/motionblur-%s.mbfd",dir,ts);
+    FILE* f=fopen(path,"wb"); if(!f) return false;
+    DumpHeader o=*h; o.slots=count; o.written=count;
+    fwrite(&o,sizeof(o),1,f);
+    for(uint32_t i=h->written-count;i!=h->written;i++) fwrite(dumpSlot(h,i),1,h->slotBytes,f);
+    return fclose(f)==0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================
+// FRAME DUMP: the last few seconds of captured frames, for offline replay
+// =============================================================
+// The ring is a file mapped MAP_SHARED: a DumpHeader followed by `slots`
+// fixed-size slots, each a DumpFrame and its pixels (RGBA, bottom row first, at
+// most maxSize x maxSize). Frame i (counting from the first ever written) lives
+// in slot i % slots; the ones still present are [written - min(written,slots),
+// written). The page cache holds what was written, so the ring outlives a crash
+// of the game (the newest frame may be torn). A dump is the same layout with the
+// frames in order from slot 0; tools/mbreplay reads either. Everything is
+// little-endian, native struct layout.
+static const uint32_t DUMP_VERSION = 2;   // 2: surface samples/format and redirect in the header
+
+struct DumpFrame {
+    uint64_t t;                 // CLOCK_MONOTONIC ns at capture
+    uint32_t frame;             // render() frame counter
+    int32_t w, h;               // surface size render() ran at
+    int32_t pw, ph;             // stored pixels (downscaled, aspect kept)
+    int32_t damage[4];          // x0, y0, x1, y1 of what the game redrew
+    uint8_t mask, turns, pad[2];
+};
+
+struct DumpHeader {
+    char magic[4];              // "MBFD"
+    uint32_t version, slots, slotBytes, maxSize;
+    uint32_t written;           // frames written so far (only the render thread writes it)
+    // Kept current while mapped: the surface and settings the frames were processed with
+    uint32_t samples, fmt;      // surface MSAA samples and GL colour format (capture path)
+    uint32_t redirect;          // 1: the game drew into the reduced target
+    float gameScale;            // that target's size over the surface
+    char config[216];           // "k=v k=v ..."
+};
+static_assert(sizeof(DumpHeader)==256,"dump header layout");
+
+inline DumpFrame* dumpSlot(DumpHeader* h, uint32_t i){ return (DumpFrame*)((char*)(h+1)+(size_t)(i%h->slots)*h->slotBytes); }
+inline const DumpFrame* dumpSlot(const DumpHeader* h, uint32_t i){ return dumpSlot((DumpHeader*)h,i); }
+inline uint8_t* dumpPixels(DumpFrame* f){ return (uint8_t*)(f+1); }
+inline const uint8_t* dumpPixels(const DumpFrame* f){ return (const uint8_t*)(f+1); }
+inline size_t dumpBytes(uint32_t slots, uint32_t slotBytes){ return sizeof(DumpHeader)+(size_t)slots*slotBytes; }
+
+// Creates (truncates) path and maps an empty ring onto it; 0 on failure
+DumpHeader* dumpOpen(const char* path, uint32_t slots, uint32_t maxSize);
+void dumpClose(DumpHeader* h);
+// Writes the frames still in the ring, oldest first, to dir/motionblur-<time>.mbfd
+bool dumpSave(const DumpHeader* h, const char* dir, char* path, size_t n);
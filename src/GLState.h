@@ -0,0 +1,83 @@
+#pragma once
+#include <GLES3/gl3.h>
+
+#ifndef GL_SAMPLER_BINDING
+#define GL_SAMPLER_BINDING 0x8919
+#endif
+// Desktop GL only, not in the GLES headers
+#define GLSTATE_FRAMEBUFFER_SRGB 0x8DB9
+#define GLSTATE_POLYGON_MODE     0x0B40
+#define GLSTATE_FRONT_AND_BACK   0x0408
+#define GLSTATE_FILL             0x1B02
+
+// Everything render() and initGL() change, for callers that must hand the
+// context back as they found it (the Linux preload, the present chain, the
+// mid-frame scene capture). The pipeline also needs culling, discard and
+// alpha-to-coverage off and all colour channels writable, so save() leaves
+// them that way. Stencil state is kept per face: an app may set the back face
+// apart. On desktop GL (proc given: looks up glPolygonMode) sRGB encoding and
+// polygon mode are also saved and left off / filled.
+struct GLState {
+    GLint prog, vao, ab, rb, act, tex[3], smp[3], dfb, rfb, vp[4], sc[4], cmask[4];
+    GLint sFunc[2], sRef[2], sMask[2], sFail[2], sZFail[2], sZPass[2], sWrite[2], sClear;   // front, back
+    GLfloat clear[4], attr2[4];   // attr2: current value of generic attribute 2 (the blur's weight)
+    GLboolean on[8], srgb=0;
+    GLint poly[2]={GLSTATE_FILL,GLSTATE_FILL};
+    void (*polygonMode)(GLenum,GLenum)=0;
+
+    void save(void* (*proc)(const char*)=0){
+        glGetIntegerv(GL_CURRENT_PROGRAM,&prog); glGetIntegerv(GL_VERTEX_ARRAY_BINDING,&vao);
+        glGetIntegerv(GL_ARRAY_BUFFER_BINDING,&ab); glGetIntegerv(GL_RENDERBUFFER_BINDING,&rb);
+        glGetIntegerv(GL_ACTIVE_TEXTURE,&act);
+        for(int i=0;i<3;i++){
+            glActiveTexture(GL_TEXTURE0+i); glGetIntegerv(GL_TEXTURE_BINDING_2D,&tex[i]);
+            glGetIntegerv(GL_SAMPLER_BINDING,&smp[i]); glBindSampler(i,0);
+        }
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING,&dfb); glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING,&rfb);
+        glGetIntegerv(GL_VIEWPORT,vp); glGetIntegerv(GL_SCISSOR_BOX,sc); glGetIntegerv(GL_COLOR_WRITEMASK,cmask);
+        glGetIntegerv(GL_STENCIL_FUNC,&sFunc[0]); glGetIntegerv(GL_STENCIL_REF,&sRef[0]); glGetIntegerv(GL_STENCIL_VALUE_MASK,&sMask[0]);
+        glGetIntegerv(GL_STENCIL_FAIL,&sFail[0]); glGetIntegerv(GL_STENCIL_PASS_DEPTH_FAIL,&sZFail[0]); glGetIntegerv(GL_STENCIL_PASS_DEPTH_PASS,&sZPass[0]);
+        glGetIntegerv(GL_STENCIL_WRITEMASK,&sWrite[0]);
+        glGetIntegerv(GL_STENCIL_BACK_FUNC,&sFunc[1]); glGetIntegerv(GL_STENCIL_BACK_REF,&sRef[1]); glGetIntegerv(GL_STENCIL_BACK_VALUE_MASK,&sMask[1]);
+        glGetIntegerv(GL_STENCIL_BACK_FAIL,&sFail[1]); glGetIntegerv(GL_STENCIL_BACK_PASS_DEPTH_FAIL,&sZFail[1]); glGetIntegerv(GL_STENCIL_BACK_PASS_DEPTH_PASS,&sZPass[1]);
+        glGetIntegerv(GL_STENCIL_BACK_WRITEMASK,&sWrite[1]); glGetIntegerv(GL_STENCIL_CLEAR_VALUE,&sClear);
+        glGetFloatv(GL_COLOR_CLEAR_VALUE,clear); glGetVertexAttribfv(2,GL_CURRENT_VERTEX_ATTRIB,attr2);
+        for(int i=0;i<8;i++) on[i]=glIsEnabled(caps()[i]);
+        for(int i=4;i<8;i++) glDisable(caps()[i]);
+        glColorMask(1,1,1,1);
+        if(proc){
+            srgb=glIsEnabled(GLSTATE_FRAMEBUFFER_SRGB); glDisable(GLSTATE_FRAMEBUFFER_SRGB);
+            polygonMode=(void(*)(GLenum,GLenum))proc("glPolygonMode");
+            if(polygonMode){ glGetIntegerv(GLSTATE_POLYGON_MODE,poly); polygonMode(GLSTATE_FRONT_AND_BACK,GLSTATE_FILL); }
+        }
+    }
+
+    void restore() const {
+        glUseProgram(prog); glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER,ab); glBindRenderbuffer(GL_RENDERBUFFER,rb);
+        for(int i=0;i<3;i++){ glActiveTexture(GL_TEXTURE0+i); glBindTexture(GL_TEXTURE_2D,tex[i]); glBindSampler(i,smp[i]); }
+        glActiveTexture(act);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER,dfb); glBindFramebuffer(GL_READ_FRAMEBUFFER,rfb);
+        glViewport(vp[0],vp[1],vp[2],vp[3]); glScissor(sc[0],sc[1],sc[2],sc[3]);
+        glColorMask(cmask[0],cmask[1],cmask[2],cmask[3]);
+        for(int f=0;f<2;f++){
+            GLenum face=f?GL_BACK:GL_FRONT;
+            glStencilFuncSeparate(face,sFunc[f],sRef[f],sMask[f]); glStencilOpSeparate(face,sFail[f],sZFail[f],sZPass[f]); glStencilMaskSeparate(face,sWrite[f]);
+        }
+        glClearStencil(sClear);
+        glClearColor(clear[0],clear[1],clear[2],clear[3]); glVertexAttrib4fv(2,attr2);
+        for(int i=0;i<8;i++) if(on[i]) glEnable(caps()[i]); else glDisable(caps()[i]);
+        if(srgb) glEnable(GLSTATE_FRAMEBUFFER_SRGB);
+        if(polygonMode){   // separate faces only exist in compatibility contexts
+            if(poly[0]==poly[1]) polygonMode(GLSTATE_FRONT_AND_BACK,poly[0]);
+            else { polygonMode(GL_FRONT,poly[0]); polygonMode(GL_BACK,poly[1]); }
+        }
+    }
+
+    // The last four are switched off while the pipeline runs
+    static const GLenum* caps(){
+        static const GLenum c[8]={GL_DEPTH_TEST,GL_BLEND,GL_STENCIL_TEST,GL_SCISSOR_TEST,
+                                  GL_CULL_FACE,GL_RASTERIZER_DISCARD,GL_SAMPLE_ALPHA_TO_COVERAGE,GL_POLYGON_OFFSET_FILL};
+        return c;
+    }
+};
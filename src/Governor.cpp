@@ -0,0 +1,69 @@
+#include "Governor.h"
+#include <dirent.h>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// What the sample asks for, with `margin` taken off every threshold
+static int wanted(const GovernorSample& s, float margin){
+    int l=0;
+    for(int i=1;i<Governor::LEVELS;i++){
+        bool hot=s.temp>=0 && s.temp>=Governor::TEMP[i]-margin;
+        bool low=s.battery>=0 && !s.charging && s.battery<=Governor::LOW_BATTERY[i]+(margin>0?5:0);
+        if(hot || low) l=i;
+    }
+    return l;
+}
+
+int Governor::update(const GovernorSample& s){
+    int up=wanted(s,0), stay=wanted(s,HYSTERESIS);
+    if(up>level){ level=up; calm=0; }
+    else if(stay<level){ if(++calm>=HOLD){ level--; calm=0; } }   // one step per HOLD seconds
+    else calm=0;
+    return level;
+}
+
+static bool readLine(const char* path, char* out, int n){
+    FILE* f=fopen(path,"r"); if(!f) return false;
+    bool ok=fgets(out,n,f)!=0; fclose(f);
+    if(ok) out[strcspn(out,"\n")]=0;
+    return ok;
+}
+
+GovernorSample governorRead(const char* root){
+    GovernorSample s={-1,-1,false};
+    char path[PATH_MAX], v[64];   // root + a d_name of up to 255 bytes always fits
+    snprintf(path,sizeof(path),"%s/class/thermal",root);
+    if(DIR* d=opendir(path)){
+        float any=-1;
+        while(dirent* e=readdir(d)){
+            if(strncmp(e->d_name,"thermal_zone",12)) continue;
+            snprintf(path,sizeof(path),"%s/class/thermal/%s/temp",root,e->d_name);
+            if(!readLine(path,v,sizeof(v))) continue;
+            float t=atof(v); if(t>1000 || t<-1000) t/=1000;   // millidegrees on nearly every kernel
+            if(t<=0 || t>=150) continue;                       // disabled or bogus sensors
+            snprintf(path,sizeof(path),"%s/class/thermal/%s/type",root,e->d_name);
+            bool known=readLine(path,v,sizeof(v)) && (strstr(v,"cpu") || strstr(v,"gpu") || strstr(v,"soc") || strstr(v,"skin"));
+            if(known && t>s.temp) s.temp=t;
+            if(t>any) any=t;
+        }
+        closedir(d);
+        if(s.temp<0) s.temp=any;   // no recognisable zone names: the hottest of them all
+    }
+    snprintf(path,sizeof(path),"%s/class/power_supply",root);
+    if(DIR* d=opendir(path)){
+        while(dirent* e=readdir(d)){
+            if(e->d_name[0]=='.') continue;
+            snprintf(path,sizeof(path),"%s/class/power_supply/%s/type",root,e->d_name);
+            if(!readLine(path,v,sizeof(v)) || strcmp(v,"Battery")) continue;
+            snprintf(path,sizeof(path),"%s/class/power_supply/%s/capacity",root,e->d_name);
+            if(readLine(path,v,sizeof(v))) s.battery=atoi(v);
+            snprintf(path,sizeof(path),"%s/class/power_supply/%s/status",root,e->d_name);
+            s.charging=readLine(path,v,sizeof(v)) && (!strcmp(v,"Charging") || !strcmp(v,"Full"));
+            break;
+        }
+        closedir(d);
+    }
+    return s;
+}
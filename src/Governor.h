@@ -0,0 +1,41 @@
+#pragma once
+#include "Config.h"
+
+// =============================================================
+// QUALITY GOVERNOR: thermal and battery driven step-down
+// =============================================================
+// Once a second the governor reads the hottest thermal zone and the battery
+// from sysfs and picks a level; each level is a set of keys applied on top of
+// the config (render() applies them over config and A/B). It climbs as soon as
+// a threshold is crossed and only comes back down after the reading has stayed
+// HYSTERESIS below it for HOLD seconds, so a device hovering around a
+// threshold doesn't flip quality every second. The root is configurable, so a
+// fake sysfs tree (plain files) drives it on a desktop just the same.
+struct GovernorSample {
+    float temp;      // hottest cpu/gpu/soc/skin zone in degrees C, < 0 when unknown
+    int battery;     // capacity in %, < 0 when there is no battery
+    bool charging;   // plugged in (charging or full)
+};
+
+struct Governor {
+    static const int LEVELS = 4, HOLD = 10;
+    static constexpr float HYSTERESIS = 3.0f;
+    static constexpr float TEMP[LEVELS] = {0.0f, 42.0f, 46.0f, 50.0f};   // entering level n at TEMP[n] C
+    static constexpr int LOW_BATTERY[LEVELS] = {0, 20, 10, 5};           // ... or at LOW_BATTERY[n] % unplugged
+    // No sharpening, then a smaller blur target, then the history updated half a frame at a time.
+    // Steps only ever lower quality: a scale already below 0.35 or checkerboard already on stay.
+    static constexpr float SCALE = 0.35f;
+    static constexpr const char* STEPS[LEVELS] = {"", "no sharpening", "no sharpening, scale <= 0.35", "no sharpening, scale <= 0.35, checkerboard"};
+    static void apply(Config& c, int level){
+        if(level>=1) c.sharpen=0;
+        if(level>=2 && c.scale>SCALE) c.scale=SCALE;
+        if(level>=3) c.checkerboard=true;
+    }
+
+    int level=0, calm=0;   // calm: consecutive samples that would allow a lower level
+
+    // Level for this sample; call once a second
+    int update(const GovernorSample& s);
+};
+
+GovernorSample governorRead(const char* root);
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// Log-bucketed histogram in the HDR style: values (ns) below SUB are exact,
+// above that each power of two is split into SUB linear buckets, so every
+// reported value is within 1/SUB (~3%) of the truth. Fixed memory, no
+// allocation. One thread records; any thread may snapshot or reset without
+// locks (counts are atomic adds, so a racing reset loses at most the samples
+// in flight, never corrupts a bucket).
+struct Histogram {
+    static const int BITS = 5, SUB = 1<<BITS, OCT = 36, N = (OCT-BITS+1)*SUB;   // up to 2^36 ns (~68 s)
+    std::atomic<uint32_t> b[N];
+    std::atomic<uint64_t> max;
+
+    Histogram(){ reset(); }
+
+    static int bucket(uint64_t v){
+        if(v<(uint64_t)SUB) return (int)v;
+        int o=63-__builtin_clzll(v);
+        int i=(o-BITS+1)*SUB+(int)((v>>(o-BITS))&(SUB-1));
+        return i<N?i:N-1;
+    }
+    // Highest value that lands in bucket i
+    static uint64_t upper(int i){
+        if(i<SUB) return i;
+        int o=i/SUB+BITS-1;
+        return ((uint64_t)(SUB+i%SUB+1)<<(o-BITS))-1;
+    }
+
+    void record(uint64_t v){
+        b[bucket(v)].fetch_add(1,std::memory_order_relaxed);
+        uint64_t m=max.load(std::memory_order_relaxed);
+        while(v>m && !max.compare_exchange_weak(m,v,std::memory_order_relaxed));
+    }
+    void reset(){
+        for(auto& x:b) x.store(0,std::memory_order_relaxed);
+        max.store(0,std::memory_order_relaxed);
+    }
+};
+
+// Plain copy for querying; merge several windows into one
+struct HistSnapshot {
+    uint32_t b[Histogram::N];
+    uint64_t count, max;
+
+    HistSnapshot(){ memset(this,0,sizeof(*this)); }
+    void add(const Histogram& h){
+        for(int i=0;i<Histogram::N;i++){ uint32_t n=h.b[i].load(std::memory_order_relaxed); b[i]+=n; count+=n; }
+        uint64_t m=h.max.load(std::memory_order_relaxed); if(m>max) max=m;
+    }
+    // q in [0,1]; 0 when empty
+    uint64_t percentile(double q) const {
+        if(!count) return 0;
+        uint64_t want=(uint64_t)(q*count+0.5), seen=0;
+        if(want<1) want=1;
+        for(int i=0;i<Histogram::N;i++) if((seen+=b[i])>=want){ uint64_t u=Histogram::upper(i); return u<max?u:max; }
+        return max;
+    }
+};
+
+// W windows recorded round-robin. rotate() (any one thread, e.g. once a second)
+// clears the next window before publishing it, so the recorder never sees a
+// half-reset window; snapshot() merges the newest `windows` of them.
+template<int W> struct RollingHistogram {
+    Histogram win[W];
+    std::atomic<unsigned> cur{0};
+
+    void record(uint64_t v){ win[cur.load(std::memory_order_acquire)%W].record(v); }
+    void rotate(){
+        unsigned n=cur.load(std::memory_order_relaxed)+1;
+        win[n%W].reset();
+        cur.store(n,std::memory_order_release);
+    }
+    void reset(){ for(Histogram& h:win) h.reset(); }
+    HistSnapshot snapshot(int windows=W) const {
+        HistSnapshot s; unsigned c=cur.load(std::memory_order_acquire);
+        for(int i=0;i<windows && i<W;i++) s.add(win[(c%W+W-i)%W]);
+        return s;
+    }
+};
@@ -0,0 +1,33 @@
+#include "Latency.h"
+
+bool PresentLatency::attach(EGLDisplay d, EGLSurface s){
+    if(s==surf) return ok;
+    surf=s; ok=false;
+    for(Frame& f:frames) f.live=false;
+    if(!api.supported || !api.nextFrameId || !api.timestamps || !api.surfaceAttrib) return false;
+    if(!api.supported(d,s,EGL_RENDERING_COMPLETE_TIME_ANDROID) || !api.supported(d,s,EGL_DISPLAY_PRESENT_TIME_ANDROID)) return false;
+    return ok=api.surfaceAttrib(d,s,EGL_TIMESTAMPS_ANDROID,EGL_TRUE)==EGL_TRUE;
+}
+
+void PresentLatency::beforeSwap(EGLDisplay d, EGLSurface s, uint64_t request, uint64_t submit){
+    if(!attach(d,s)) return;
+    EGLuint64KHR id;
+    if(!api.nextFrameId(d,s,&id)) return;
+    frames[next++%PENDING]={id,request,submit,true};   // overwrites a frame that never completed
+}
+
+void PresentLatency::poll(EGLDisplay d, EGLSurface s){
+    if(s!=surf || !ok) return;
+    static const EGLint names[2]={EGL_RENDERING_COMPLETE_TIME_ANDROID,EGL_DISPLAY_PRESENT_TIME_ANDROID};
+    for(Frame& f:frames){
+        if(!f.live) continue;
+        EGLnsecsANDROID v[2];
+        if(!api.timestamps(d,s,f.id,2,names,v)){ f.live=false; continue; }   // too old, the driver dropped it
+        if(v[0]==EGL_TIMESTAMP_PENDING_ANDROID || v[1]==EGL_TIMESTAMP_PENDING_ANDROID) continue;
+        f.live=false;
+        if(v[0]<0 || v[1]<0 || (uint64_t)v[1]<f.request) continue;   // invalid: frame was dropped by the compositor
+        gpuDone.record((uint64_t)v[0]>f.request ? v[0]-f.request : 0);
+        display.record(v[1]-f.request);
+        extra.record(f.submit-f.request+gpuAvg);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstdint>
+#include "Histogram.h"
+
+// =============================================================
+// PRESENT LATENCY (EGL_ANDROID_get_frame_timestamps)
+// =============================================================
+// The extension is reached only through this table, so the bookkeeping below
+// can be driven by a fake compositor on a desktop build: fill the four
+// pointers with functions that hand back scripted timestamps.
+struct FrameTimestampsApi {
+    PFNEGLGETFRAMETIMESTAMPSUPPORTEDANDROIDPROC supported;
+    PFNEGLGETNEXTFRAMEIDANDROIDPROC nextFrameId;
+    PFNEGLGETFRAMETIMESTAMPSANDROIDPROC timestamps;
+    EGLBoolean (*surfaceAttrib)(EGLDisplay,EGLSurface,EGLint,EGLint);
+};
+
+// Per frame, from the game's swap request (hook entry) to
+//   gpuDone: the GPU finished the frame, our passes included
+//   display: the frame reached the panel
+// extra is what render() added: the CPU time before the real swap was queued
+// plus the GPU time of our own passes (a running average fed by the timer queries).
+struct PresentLatency {
+    static const int PENDING = 8;   // frames in flight; results usually arrive 2-3 swaps later
+    static const int WINDOWS = 10;
+
+    FrameTimestampsApi api{};
+    RollingHistogram<WINDOWS> gpuDone, display, extra;
+
+    // false when the driver can't report the timestamps we need
+    bool attach(EGLDisplay d, EGLSurface s);
+    // Right before the real swap: request = hook entry, submit = now
+    void beforeSwap(EGLDisplay d, EGLSurface s, uint64_t request, uint64_t submit);
+    // After the real swap: collect whatever has completed
+    void poll(EGLDisplay d, EGLSurface s);
+    void ourGpu(uint64_t ns){ gpuAvg = gpuAvg ? (gpuAvg*15+ns)/16 : ns; }
+    void rotate(){ gpuDone.rotate(); display.rotate(); extra.rotate(); }
+
+    // Frames waiting for their timestamps
+    struct Frame { EGLuint64KHR id; uint64_t request, submit; bool live; };
+    Frame frames[PENDING]{};
+    unsigned next=0;
+    EGLSurface surf=0; bool ok=false;
+    uint64_t gpuAvg=0;
+};
@@ -0,0 +1,158 @@
+// Linux desktop backend: LD_PRELOAD=libmotionblur_preload.so <app>
+// Interposes glXSwapBuffers and eglSwapBuffers (and hands out the same hooks
+// through glXGetProcAddress / eglGetProcAddress) and runs the pipeline on the
+// back buffer of GL 3.3+ desktop contexts and GLES 3 contexts. Unlike the
+// game, a desktop app may set state once and rely on it for every frame, so
+// everything render() touches is saved and restored around it.
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Log.h"
+#include "Config.h"
+#include "Pipeline.h"
+#include "Telemetry.h"
+#include "Governor.h"
+#include "GLState.h"
+
+#define EXPORT extern "C" __attribute__((visibility("default")))
+
+// =============================================================
+// 1. SETTINGS
+// =============================================================
+// MOTIONBLUR_CONFIG: config file (same keys as on Android), re-read when it changes
+static const char* CONFIG_ENV = "MOTIONBLUR_CONFIG";
+static const int MIN_SIZE = 100;   // smaller surfaces (splash windows, offscreen 1x1) pass through
+
+// Minimal GLX, resolved at runtime: no libGL link, no GL/gl.h next to the GLES headers
+typedef struct _XDisplay Display;
+typedef unsigned long GLXDrawable;
+#define GLX_WIDTH  0x801D
+#define GLX_HEIGHT 0x801E
+
+static void (*oGlxSwap)(Display*,GLXDrawable)=0;
+static void* (*oGlxProc)(const unsigned char*)=0;
+static void* (*oGlxProcARB)(const unsigned char*)=0;
+static void* (*oGlxContext)()=0;
+static void (*oGlxQuery)(Display*,GLXDrawable,int,unsigned int*)=0;
+static EGLBoolean (*oEglSwap)(EGLDisplay,EGLSurface)=0;
+static __eglMustCastToProperFunctionPointerType (*oEglProc)(const char*)=0;
+
+static void resolve(){
+    static pthread_once_t once=PTHREAD_ONCE_INIT;
+    pthread_once(&once,[]{
+        oGlxSwap=(void(*)(Display*,GLXDrawable))dlsym(RTLD_NEXT,"glXSwapBuffers");
+        oGlxProc=(void*(*)(const unsigned char*))dlsym(RTLD_NEXT,"glXGetProcAddress");
+        oGlxProcARB=(void*(*)(const unsigned char*))dlsym(RTLD_NEXT,"glXGetProcAddressARB");
+        oGlxContext=(void*(*)())dlsym(RTLD_NEXT,"glXGetCurrentContext");
+        oGlxQuery=(void(*)(Display*,GLXDrawable,int,unsigned int*))dlsym(RTLD_NEXT,"glXQueryDrawable");
+        oEglSwap=(EGLBoolean(*)(EGLDisplay,EGLSurface))dlsym(RTLD_NEXT,"eglSwapBuffers");
+        oEglProc=(__eglMustCastToProperFunctionPointerType(*)(const char*))dlsym(RTLD_NEXT,"eglGetProcAddress");
+    });
+}
+
+// =============================================================
+// 2. PRESENT
+// =============================================================
+// The pipeline's objects live in the first suitable context; any other
+// context in the process passes through untouched.
+static void* owner=0;
+static bool unsupported=false;
+
+// GL 3.3+ or GLES 3.0+; decides the shader dialect on first use
+static bool suitable(void* ctx, bool glx){
+    if(owner) return ctx==owner;
+    if(unsupported) return false;
+    const char* v=(const char*)glGetString(GL_VERSION);
+    int major=0, minor=0;
+    bool es=v && !strncmp(v,"OpenGL ES",9);
+    if(v) sscanf(es?v+10:v,"%d.%d",&major,&minor);
+    if(es ? major<3 : major*10+minor<33){ LOG("linux: %s context %s is too old, passing through",glx?"GLX":"EGL",v?v:"?"); unsupported=true; return false; }
+    desktop=!es; glslVersion=es?"#version 300 es":"#version 330 core";
+    if(glx) getProc=[](const char* n){ return oGlxProcARB?oGlxProcARB((const unsigned char*)n):oGlxProc((const unsigned char*)n); };
+    owner=ctx;
+    LOG("linux: running on %s (%s)",v,(const char*)glGetString(GL_RENDERER));
+    return true;
+}
+
+static void present(void* key, int w, int h){
+    if(w<MIN_SIZE || h<MIN_SIZE) return;
+    GLState st; st.save(desktop?getProc:0);
+    glBindFramebuffer(GL_FRAMEBUFFER,0);
+    GLint samples=0; glGetIntegerv(GL_SAMPLES,&samples);
+    if(key!=surf.s || samples!=surf.samples) surf={(EGLSurface)key,samples,GL_RGBA8,0};   // stencil 0: HUD pixels are graded too
+    render(w,h);
+    st.restore();
+    while(glGetError()!=GL_NO_ERROR){}   // ours, e.g. queries a driver doesn't know
+}
+
+// =============================================================
+// 3. INTERPOSED ENTRY POINTS
+// =============================================================
+EXPORT void glXSwapBuffers(Display* d, GLXDrawable w){
+    resolve();
+    void* ctx=oGlxContext?oGlxContext():0;
+    if(ctx && oGlxQuery && suitable(ctx,true)){
+        unsigned int pw=0, ph=0;
+        oGlxQuery(d,w,GLX_WIDTH,&pw); oGlxQuery(d,w,GLX_HEIGHT,&ph);
+        present((void*)w,(int)pw,(int)ph);
+    }
+    if(oGlxSwap) oGlxSwap(d,w);
+}
+
+EXPORT EGLBoolean eglSwapBuffers(EGLDisplay d, EGLSurface s){
+    resolve();
+    EGLContext ctx=eglGetCurrentContext();
+    if(ctx!=EGL_NO_CONTEXT && suitable(ctx,false)){
+        EGLint w=0, h=0;
+        eglQuerySurface(d,s,EGL_WIDTH,&w); eglQuerySurface(d,s,EGL_HEIGHT,&h);
+        present(s,w,h);
+    }
+    return oEglSwap?oEglSwap(d,s):EGL_FALSE;
+}
+
+// Apps that look the swap up at runtime (GLFW, SDL's GL loaders) get the hooks too
+EXPORT void* glXGetProcAddressARB(const unsigned char* n){
+    resolve();
+    if(!strcmp((const char*)n,"glXSwapBuffers")) return (void*)glXSwapBuffers;
+    return oGlxProcARB?oGlxProcARB(n):0;
+}
+EXPORT void* glXGetProcAddress(const unsigned char* n){
+    resolve();
+    if(!strcmp((const char*)n,"glXSwapBuffers")) return (void*)glXSwapBuffers;
+    return oGlxProc?oGlxProc(n):0;
+}
+EXPORT __eglMustCastToProperFunctionPointerType eglGetProcAddress(const char* n){
+    resolve();
+    if(!strcmp(n,"eglSwapBuffers")) return (__eglMustCastToProperFunctionPointerType)eglSwapBuffers;
+    return oEglProc?oEglProc(n):0;
+}
+
+// =============================================================
+// 4. STARTUP
+// =============================================================
+// Config watcher and quality governor, once a second as on Android
+static void* watcher(void*){
+    const char* path=getenv(CONFIG_ENV);
+    Governor g;
+    for(time_t seen=0;;sleep(1)){
+        struct stat st;
+        if(path && stat(path,&st)==0 && st.st_mtime!=seen){
+            Config c; seen=st.st_mtime;
+            if(loadConfig(path,c)){ pthread_mutex_lock(&configWrite); config.store(c); pthread_mutex_unlock(&configWrite); LOG("linux: config %s loaded",path); }
+        }
+        Config c=config.load();
+        int was=g.level;
+        if(c.governor) g.update(governorRead(c.sysfsRoot)); else g=Governor();
+        if(g.level!=was){ governorLevel.store(g.level,std::memory_order_relaxed); LOG("linux: governor level %d",g.level); }
+    }
+    return 0;
+}
+
+__attribute__((constructor)) static void init(){ traceWriterStart(); pthread_t t; if(pthread_create(&t,0,watcher,0)==0) pthread_detach(t); }
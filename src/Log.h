@@ -0,0 +1,10 @@
+#pragma once
+
+// logcat on the device, stderr for the host tools that link the pipeline
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG(...) __android_log_print(ANDROID_LOG_INFO,"MotionBlur",__VA_ARGS__)
+#else
+#include <cstdio>
+#define LOG(...) (fprintf(stderr,"MotionBlur: " __VA_ARGS__), fputc('\n',stderr))
+#endif
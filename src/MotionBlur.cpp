@@ -0,0 +1,119 @@
+#include "MotionBlur.h"
+#include "MotionBlurApi.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// =============================================================
+// 1. C++ API
+// =============================================================
+MotionBlurPipeline& MotionBlurPipeline::instance(){ static MotionBlurPipeline p; return p; }
+
+bool MotionBlurPipeline::init(bool desktopGL, void* (*proc)(const char*)){
+    desktop=desktopGL; glslVersion=desktopGL?"#version 330 core":"#version 300 es";
+    if(proc) getProc=proc;
+    sW=0;   // rebuild with this flavour on the next process
+    traceWriterStart();   // the pipeline's log lines are formatted there
+    return true;
+}
+
+void MotionBlurPipeline::resize(int width, int height){ w=width; h=height; }
+
+// The input as the pipeline's surface: samples and colour format (as surfaceInfo()
+// takes them from an EGL config), the FBO name standing in for the EGLSurface.
+// Stencil 0: there is no HUD to keep, everything is graded.
+static EGLSurface inputKey(GLuint in){ return (EGLSurface)(uintptr_t)(in+1); }
+static SurfaceInfo inputInfo(GLuint in){
+    static const GLenum BACK_LEFT=0x0402;   // desktop GL names the default colour buffer this way
+    SurfaceInfo r={inputKey(in),0,GL_RGBA8,0};
+    glBindFramebuffer(GL_FRAMEBUFFER,in); glGetIntegerv(GL_SAMPLES,&r.samples);
+    GLenum at=in?GL_COLOR_ATTACHMENT0:desktop?BACK_LEFT:GL_BACK;
+    GLint type=GL_NONE; glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER,at,GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE,&type);
+    if(type==GL_NONE) return r;
+    GLint rs=8,gs=8,bs=8,as=8;
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER,at,GL_FRAMEBUFFER_ATTACHMENT_RED_SIZE,&rs); glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER,at,GL_FRAMEBUFFER_ATTACHMENT_GREEN_SIZE,&gs);
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER,at,GL_FRAMEBUFFER_ATTACHMENT_BLUE_SIZE,&bs); glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER,at,GL_FRAMEBUFFER_ATTACHMENT_ALPHA_SIZE,&as);
+    r.fmt = rs==5&&gs==6&&bs==5 ? GL_RGB565 : rs==10 ? GL_RGB10_A2 : as==0 ? GL_RGB8 : GL_RGBA8;
+    return r;
+}
+
+void MotionBlurPipeline::process(GLuint in, GLuint out, const Rect* damage){
+    if(w<=0 || h<=0) return;
+    if(surf.s!=inputKey(in)) surf=inputInfo(in);   // also after the hook processed its own surface
+    inputFBO=in; outputFBO=out;
+    render(w,h,true,damage);
+    inputFBO=outputFBO=0;
+}
+
+void MotionBlurPipeline::processTexture(GLuint tex, GLuint out){
+    if(!texFBO) glGenFramebuffers(1,&texFBO);
+    if(tex!=texBound){
+        glBindFramebuffer(GL_FRAMEBUFFER,texFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,tex,0);
+        texBound=tex; surf.s=0;   // same FBO, maybe another format: read it again
+    }
+    process(texFBO,out);
+}
+
+MotionBlurPipeline::Stats MotionBlurPipeline::stats() const {
+    FrameTextures t=frameTextures();
+    Stats s={frame,sW,sH,t.w,t.h,levels,slots,capture,{},texBytes};
+    std::copy(gpuLast,gpuLast+PASS_COUNT,s.gpuMs);
+    return s;
+}
+
+bool MotionBlurPipeline::configure(const char* keys){
+    pthread_mutex_lock(&configWrite);
+    Config c=config.load(); bool ok=applyKeys(c,keys);
+    if(ok){ if(c.maskOuter<c.maskInner) c.maskOuter=c.maskInner; config.store(c); }
+    pthread_mutex_unlock(&configWrite);
+    return ok;
+}
+
+// =============================================================
+// 2. C ABI (MotionBlurApi.h)
+// =============================================================
+// The mod and the preload library run the engine from their own swap hook, so
+// they only hand out what it left behind: a second caller driving init/process
+// would fight the hook over the same GL objects. A library that builds this
+// file without a hook of its own defines MOTIONBLUR_STANDALONE for the rest.
+static MotionBlurPipeline& shared=MotionBlurPipeline::instance();
+
+// Fill no more than the caller's struct knows about; size says how much that was
+template<class T> static int give(T* out, const T& v){
+    if(!out || out->size<sizeof(unsigned)) return 0;
+    unsigned n=(unsigned)std::min<size_t>(out->size,sizeof(T));
+    memcpy(out,&v,n); out->size=n;
+    return 1;
+}
+
+extern "C" {
+
+int motionblur_api_version(void){ return MOTIONBLUR_API_VERSION; }
+
+#ifdef MOTIONBLUR_STANDALONE
+int motionblur_init(int desktopGL, void* (*proc)(const char*)){ return shared.init(desktopGL!=0,proc); }
+void motionblur_resize(int w, int h){ shared.resize(w,h); }
+
+void motionblur_process(unsigned in, unsigned out, const int* d){
+    Rect r; if(d) r={d[0],d[1],d[2],d[3]};
+    shared.process(in,out,d?&r:0);
+}
+void motionblur_process_texture(unsigned tex, unsigned out){ shared.processTexture(tex,out); }
+int motionblur_set(const char* keys){ return keys && shared.configure(keys); }
+#endif
+
+int motionblur_frame(MotionBlurFrame* out){
+    FrameTextures t=shared.output();
+    return give(out,MotionBlurFrame{sizeof(MotionBlurFrame),t.frame,t.capture,t.history,t.w,t.h,t.levels});
+}
+
+int motionblur_stats(MotionBlurStats* out){
+    MotionBlurPipeline::Stats s=shared.stats();
+    MotionBlurStats v={sizeof(MotionBlurStats),s.frame,s.w,s.h,s.internalW,s.internalH,s.levels,s.ring,s.capture,
+                       {s.gpuMs[0],s.gpuMs[1],s.gpuMs[2]},s.textureBytes};
+    return give(out,v);
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "Pipeline.h"
+
+// =============================================================
+// EMBEDDING: the pipeline as an object
+// =============================================================
+// For code that owns its frame loop (another mod, a host app, a test) rather
+// than hooking a swap. The engine behind it is the process-wide one in
+// Pipeline.cpp - there is one GL pipeline per process, like the context it
+// lives in - so there is one MotionBlurPipeline too: instance(), not copyable,
+// and the mod's own hook is one more client of the same capture and history.
+// MotionBlurApi.h is the same thing as a C ABI for other .so files.
+class MotionBlurPipeline {
+public:
+    static MotionBlurPipeline& instance();
+    MotionBlurPipeline(const MotionBlurPipeline&)=delete;
+    MotionBlurPipeline& operator=(const MotionBlurPipeline&)=delete;
+
+    struct Stats {
+        unsigned frame;
+        int w, h, internalW, internalH, levels, ring, capture;
+        double gpuMs[PASS_COUNT];
+        size_t textureBytes;
+    };
+
+    // Context flavour; call with the context current, before the first process()
+    bool init(bool desktopGL=false, void* (*proc)(const char*)=0);
+    void resize(int w, int h);
+    // Reads inputFBO (0 = default framebuffer) at the resize() size, writes outputFBO.
+    // The input's samples and colour format are read again whenever it changes.
+    void process(GLuint inputFBO, GLuint outputFBO, const Rect* damage=0);
+    void processTexture(GLuint inputTexture, GLuint outputFBO);
+    // Last processed frame (this pipeline's or the hook's)
+    FrameTextures output() const { return frameTextures(); }
+    Stats stats() const;
+    // "k=v k=v", applied to the shared config; false (and nothing applied) if a key is invalid
+    bool configure(const char* keys);
+
+private:
+    MotionBlurPipeline()=default;
+    int w=0, h=0;
+    GLuint texFBO=0, texBound=0;   // wraps processTexture()'s input
+};
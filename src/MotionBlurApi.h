@@ -0,0 +1,72 @@
+#ifndef MOTIONBLUR_API_H
+#define MOTIONBLUR_API_H
+
+/* =============================================================
+ * MOTIONBLUR C ABI (stable across releases, plain C)
+ * =============================================================
+ * Exported by the mod (libDisplayFPS.so) and the Linux preload library, so
+ * another .so can reuse the frame we already captured instead of copying the
+ * screen itself: dlopen the library (RTLD_NOLOAD if it is already in the
+ * process) and dlsym the functions below. Those two run the pipeline from their
+ * own swap hook and export only the read side (api_version, frame, stats);
+ * the rest exists where MotionBlur.cpp is built with MOTIONBLUR_STANDALONE.
+ *
+ * Every call is GL work and must come from the thread that has the pipeline's
+ * context current (inside the mod that is the game's eglSwapBuffers, which is
+ * where the mod itself processes). Texture names are only meaningful in that
+ * context and stay valid until the next motionblur_process or present.
+ *
+ * Structs start with a size field the caller sets to sizeof(struct); newer
+ * libraries only fill what the caller knows about, older ones what they know
+ * about, and either way size comes back as the bytes filled. Functions are
+ * only ever added, never changed. */
+
+#define MOTIONBLUR_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOTIONBLUR_EXPORT __attribute__((visibility("default")))
+
+typedef struct {
+    unsigned size;            /* sizeof(MotionBlurFrame), set by the caller */
+    unsigned frame;           /* frames processed so far, 0 = none yet */
+    unsigned capture;         /* GL_TEXTURE_2D, RGBA8: this frame at internal resolution */
+    unsigned history;         /* GL_TEXTURE_2D, RGBA8: the blurred result that was upscaled to the screen */
+    int width, height;        /* of both textures */
+    int levels;               /* > 1: foveation is on and the textures only hold the centre band */
+} MotionBlurFrame;
+
+typedef struct {
+    unsigned size;            /* sizeof(MotionBlurStats), set by the caller */
+    unsigned frame;
+    int width, height;        /* surface (or motionblur_resize) size */
+    int internal_width, internal_height;
+    int levels, ring;
+    int capture;              /* 0 blit, 1 multisample resolve, 2 resolve + downscale */
+    double gpu_ms[3];         /* capture, blur, output of the last timed frame (0 without timer queries) */
+    unsigned long long texture_bytes;
+} MotionBlurStats;
+
+MOTIONBLUR_EXPORT int motionblur_api_version(void);
+
+/* Standalone builds only (MOTIONBLUR_STANDALONE): desktop_gl = 1 for a GL 3.3 core context, 0 for GLES 3.
+ * get_proc may be 0 (eglGetProcAddress). */
+MOTIONBLUR_EXPORT int motionblur_init(int desktop_gl, void* (*get_proc)(const char*));
+MOTIONBLUR_EXPORT void motionblur_resize(int width, int height);
+/* Reads input_fbo (0 = default framebuffer), writes output_fbo; damage = x0,y0,x1,y1 or 0 */
+MOTIONBLUR_EXPORT void motionblur_process(unsigned input_fbo, unsigned output_fbo, const int* damage);
+MOTIONBLUR_EXPORT void motionblur_process_texture(unsigned input_texture, unsigned output_fbo);
+/* "key=value key=value" as in the config file; 0 if any key is invalid (nothing applied) */
+MOTIONBLUR_EXPORT int motionblur_set(const char* keys);
+
+/* Shared access: what the last processed frame left behind */
+MOTIONBLUR_EXPORT int motionblur_frame(MotionBlurFrame* out);
+MOTIONBLUR_EXPORT int motionblur_stats(MotionBlurStats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,772 @@
+#include "Pipeline.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Telemetry.h"
+#include "Governor.h"
+#include "Log.h"
+
+// =============================================================
+// 2. SHADERS (Verified & Optimized)
+// =============================================================
+
+const char* vert = R"(#version 300 es
+layout(location=0) in vec4 p; layout(location=1) in vec2 t; layout(location=2) in float a;
+out mediump vec2 v; out lowp float w;
+void main(){gl_Position=p;v=t;w=a;})";
+
+// Output pass only: pre-rotation for surfaces the compositor would otherwise rotate
+const char* vert_out = R"(#version 300 es
+layout(location=0) in vec4 p; layout(location=1) in vec2 t; uniform mediump mat2 R;
+out mediump vec2 v;
+void main(){gl_Position=vec4(R*p.xy,0.0,1.0);v=t;})";
+
+// --- PASS 1: VELOCITY ACCUMULATION ---
+const char* frag_blur = R"(#version 300 es
+precision mediump float;
+in mediump vec2 v;
+in lowp float w;     // Centre Mask Weight (precomputed per vertex, 1 = full blur)
+uniform sampler2D c; // Current Frame
+uniform sampler2D h; // History Frame
+uniform lowp float k; // Checkerboard (history is 2 frames old: square the factor)
+out vec4 o;
+
+void main() {
+    lowp vec4 curr = texture(c, v);
+    lowp vec4 hist = texture(h, v);
+
+    // 1. VELOCITY CALCULATOR (Anti-Ghosting)
+    lowp float lC = dot(curr.rgb, vec3(0.299, 0.587, 0.114));
+    lowp float lH = dot(hist.rgb, vec3(0.299, 0.587, 0.114));
+    lowp float diff = abs(lC - lH);
+
+    // Dynamic Interpolation:
+    // Low Diff (Walking) -> Max Blur (0.94)
+    // High Diff (Flicking) -> Min Blur (0.35)
+    lowp float velocity = smoothstep(0.02, 0.30, diff);
+    lowp float factor = mix(0.94, 0.35, velocity);
+    factor *= mix(1.0, factor, k);
+
+    // 2. SHADOW PROTECTION (Contrast Fix)
+    // If history is darker than current, we favor it slightly.
+    // This prevents shadows from turning gray during movement.
+    lowp vec4 result = mix(curr, hist, factor);
+    if (lH < lC) { 
+        result = mix(result, hist, 0.05); 
+    }
+
+    // 3. CENTER MASK (PvP Aim)
+    // The fully protected core is never drawn by this pass (see buildMesh)
+    o = mix(curr, result, w);
+})";
+
+// --- UI MASK: STABILITY LEARNING (1/MASK_DIV res) ---
+const char* frag_mask = R"(#version 300 es
+precision mediump float;
+in mediump vec2 v;
+uniform sampler2D c; // Current Frame
+uniform sampler2D h; // Previous Mask (rgb = last colour, a = stability)
+uniform sampler2D g; // Previous Change Map (mipmapped: its last level is the fraction that changed)
+uniform mediump float r;   // Stability gained per frame
+uniform mediump float top; // Last mip level of g
+uniform mediump float q;   // Changed fraction that counts as a moving scene
+layout(location=0) out vec4 o;
+layout(location=1) out vec4 m;
+
+void main() {
+    lowp vec3 curr = texture(c, v).rgb;
+    lowp vec4 prev = texture(h, v);
+    lowp vec3 d = abs(curr - prev.rgb);
+    bool changed = max(max(d.r, d.g), d.b) > 0.01;
+
+    // Any change resets the pixel; unchanged ones slowly earn their way out, but
+    // only while the scene around them moves. A static scene says nothing about
+    // what is HUD: learning there would mask the whole screen, and the output
+    // pass would then skip the grade everywhere until something moved.
+    lowp float gain = textureLod(g, vec2(0.5), top).r > q ? r : 0.0;
+    o = vec4(curr, changed ? 0.0 : min(prev.a + gain, 1.0));
+    m = vec4(changed ? 1.0 : 0.0);
+})";
+
+// --- UI MASK: STENCIL MARK ---
+const char* frag_stencil = R"(#version 300 es
+precision mediump float;
+in mediump vec2 v;
+uniform sampler2D k; // UI Mask
+out vec4 o;
+
+void main() {
+    if (texture(k, v).a < 0.99) discard;
+    o = vec4(0.0);
+})";
+
+// --- PLAIN COPY (masked pixels) ---
+const char* frag_copy = R"(#version 300 es
+precision mediump float;
+in mediump vec2 v;
+uniform sampler2D t;
+out vec4 o;
+
+void main() { o = texture(t, v); })";
+
+// --- CHECKERBOARD STENCIL PATTERN (written once per resize) ---
+const char* frag_pattern = R"(#version 300 es
+precision mediump float;
+out vec4 o;
+
+void main() {
+    if (((int(gl_FragCoord.x) + int(gl_FragCoord.y)) & 1) == 0) discard;
+    o = vec4(0.0);
+})";
+
+// --- PASS 2: CLARITY & OUTPUT ---
+// Compiled with "#define CAS 0|1" after the version line (sharpen = 0 drops the CAS block)
+const char* frag_draw = R"(#version 300 es
+precision mediump float;
+in mediump vec2 v;
+uniform sampler2D t;
+uniform lowp float k; // Checkerboard Reconstruction
+uniform lowp float a; // Sharpen Strength
+out vec4 o;
+
+void main() {
+    // 1. CAS SHARPENING (Contrast Adaptive Sharpening)
+    lowp vec4 col = texture(t, v), n = col, s = col, e = col, w = col;
+
+#if !CAS
+    if(k > 0.0)   // unsharpened (outer fovea bands): neighbours only for the checkerboard clamp
+#endif
+    {
+        // Read 4 neighbors
+        n = textureOffset(t, v, ivec2(0, -1));
+        s = textureOffset(t, v, ivec2(0, 1));
+        e = textureOffset(t, v, ivec2(1, 0));
+        w = textureOffset(t, v, ivec2(-1, 0));
+
+        // Checkerboard: half the texels are a frame old, pull them into the range of their fresh neighbours
+        col = mix(col, clamp(col, min(min(n, s), min(e, w)), max(max(n, s), max(e, w))), k);
+    }
+
+#if CAS
+    // Calculate Luma for cheap/fast processing
+    lowp float lC = dot(col.rgb, vec3(0.299, 0.587, 0.114));
+    lowp float lN = dot(n.rgb, vec3(0.299, 0.587, 0.114));
+    lowp float lS = dot(s.rgb, vec3(0.299, 0.587, 0.114));
+    lowp float lE = dot(e.rgb, vec3(0.299, 0.587, 0.114));
+    lowp float lW = dot(w.rgb, vec3(0.299, 0.587, 0.114));
+
+    // Calculate Contrast
+    lowp float mx = max(lC, max(max(lN, lS), max(lE, lW)));
+    lowp float mn = min(lC, min(min(lN, lS), min(lE, lW)));
+    lowp float amt = sqrt(clamp(mn / (1.0 - mx + 0.001), 0.0, 1.0));
+    
+    // Apply Sharpening (Strength: sharpen, 0.88 by default)
+    lowp float peak = -1.0 / mix(8.0, 5.0, amt * a); 
+    lowp float sharpLuma = lC + (lN + lS + lE + lW) * peak;
+    sharpLuma /= (1.0 + 4.0 * peak);
+    
+    // Apply Luma delta to Color
+    col.rgb += (sharpLuma - lC);
+#endif
+
+    // 2. VIBRANCE (Color Restoration)
+    // Boosts muted colors slightly to counter blur washout
+    lowp float maxRGB = max(col.r, max(col.g, col.b));
+    lowp float minRGB = min(col.r, min(col.g, col.b));
+    lowp float sat = maxRGB - minRGB;
+    col.rgb = mix(col.rgb, vec3(maxRGB), (1.0 - pow(sat, 0.5)) * -0.2);
+
+    // 3. ACES TONEMAP
+    lowp vec3 x = col.rgb;
+    col.rgb = clamp((x*(2.51*x+0.03))/(x*(2.43*x+0.59)+0.14), 0.0, 1.0);
+
+    // 4. ALPHA SAFETY (Fixes UI Bugs)
+    o = vec4(col.rgb, 1.0);
+})";
+
+// =============================================================
+// 3. RENDER ENGINE
+// =============================================================
+// Level 0 is the internal resolution. With foveation, levels 1-2 cover the outer
+// rings at 1/2 and 1/4 of that per axis; each keeps its own capture and history.
+struct Level { GLuint raw[3], rawFBO[3], hist[3], histFBO[3], rb; int w, h; };
+struct Range { GLint first, count; };
+static Level lv[3];
+static GLuint vao=0, quadVB=0, quadIB=0;
+static GLuint progBlur=0, progDraw[2]={0,0}, progMask=0, progStencil=0, progCopy=0, progPattern=0;   // progDraw: level 0, outer bands (no CAS)
+static GLint uCbBlur=-1, uCbDraw[2], uSharpen[2], uRot[2];
+int turns=0; static int turnsSet[2];   // quarter turns (clockwise on screen) applied by the output pass
+static GLuint maskTex[2]={0,0}, maskFBO[2]={0,0}, moveTex[2]={0,0}; static int moveTop=0;
+static GLuint meshVAO=0, meshVB=0;
+static Range ringR, coreR, bandR[3], procR[3];   // mesh ranges: masked blur area, protected core, per-level output / processed band
+static float ext[3]={1,1,1}, margin=0;            // per-axis screen extent covered up to each level, overlap between levels
+int levels=1; static int mW=0, mH=0;
+unsigned frame=0;
+size_t texBytes=0;   // everything initGL() allocated
+
+SurfaceInfo surf={0,0,GL_RGBA8,0}; static SurfaceInfo built={0,-1,0,0};   // current surface, what initGL() was built for
+static GLuint resolveTex=0, resolveFBO=0;
+static GLuint readTex=0, readFBO=0; static int readW=0, readH=0;   // bindReadable()
+int capture=CAP_BLIT;
+Config cfg;
+static unsigned cfgVer=~0u;
+static GLuint gameTex=0, gameRB=0;
+GLuint gameFBO=0, inputFBO=0, outputFBO=0;
+int slots=2, sW=0, sH=0, gW=0, gH=0; static int iW=0, iH=0;
+static bool seed=false;   // the history was just cleared: the next blur pass starts it from the capture
+bool redirect=false;   // set once the framebuffer hooks are installed
+float gameScale=GAME_SCALE;
+static Rect decay[DECAY_FRAMES], shown[DECAY_FRAMES]; Rect processed;   // recent game damage (still fading in the history), recent processed areas, the last one
+static int decayAt=0;
+int bufferAge=0;
+void (*captureTap)(const CaptureInfo&)=0;
+const char* glslVersion="#version 300 es";
+bool desktop=false;
+void* (*getProc)(const char*)=[](const char* n){ return (void*)eglGetProcAddress(n); };
+
+Rect decayRegion(){
+    Rect u={0,0,0,0}; for(int i=0;i<DECAY_FRAMES;i++) u=unite(u,decay[i]);
+    if(u.empty()) return u;
+    int m=(int)(2.0f*(1<<(levels-1))/cfg.scale)+2;
+    return {u.x0-m,u.y0-m,u.x1+m,u.y1+m};
+}
+
+// What changed in our output since the frame a buffer of this age last held
+Rect repairRegion(int age){
+    Rect u={0,0,0,0}; for(int k=0;k<age-1;k++) u=unite(u,shown[(decayAt-1-k+DECAY_FRAMES)%DECAY_FRAMES]);
+    return u;
+}
+
+// A/B state. Frames right after a flip are left out: textures may be rebuilt and the
+// previous variant's GPU work is still in flight.
+static AbConfig ab; static unsigned abVer=~0u, abStart=0;   // blocks count from the frame A/B was set
+unsigned abBlock=0; int variant=-1, abPos=0, abWarmup=AB_WARMUP;
+static Config cfgBase;
+std::atomic<int> governorLevel{0}; static int govSeen=0;
+AbMetric abGpu, abHook, abSwap;
+const char* abName[3] = {"gpu","hook","swap"};
+Seqlock<AbSummary> abSummary;
+
+static void abPublish(){
+    AbSummary s={ab.every,{}}; AbMetric* m[3]={&abGpu,&abHook,&abSwap};
+    bool any=false;
+    for(int i=0;i<3;i++){
+        auto& o=s.m[i];
+        o.a=m[i]->blocks[0].mean*1e-6; o.b=m[i]->blocks[1].mean*1e-6; o.na=(int)m[i]->blocks[0].n; o.nb=(int)m[i]->blocks[1].n;
+        o.ok=m[i]->diff(o.d,o.ci); o.d*=1e-6; o.ci*=1e-6;
+        for(int v=0;v<2;v++){ HistSnapshot h; h.add(m[i]->frames[v]); o.p50[v]=h.percentile(0.5)*1e-6; o.p99[v]=h.percentile(0.99)*1e-6; }
+        if(o.ok) logLater("A/B every %d (B - A): %s %+.3f +/- %.3f ms (%.3f vs %.3f, %d/%d blocks; frames p50 %.3f vs %.3f, p99 %.3f vs %.3f)",
+            ab.every,abName[i],o.d,o.ci,o.a,o.b,o.na,o.nb,o.p50[0],o.p50[1],o.p99[0],o.p99[1]);
+        any|=o.ok;
+    }
+    abSummary.store(s);
+    if(!any) logLater("A/B every %d (B - A): not enough blocks yet",ab.every);
+}
+
+// =============================================================
+// 3a. GPU TIMING (EXT_disjoint_timer_query)
+// =============================================================
+// Results are read QLAT frames late so the CPU never waits on the GPU.
+// Averages + our texture footprint are logged every STATS_FRAMES frames:
+// compare ring=2 against ring=3 to see whether the driver was stalling or
+// shadow-copying the capture (capture/blur times drop when it was).
+// While tracing, each pass is also bracketed by GPU timestamps that go into the
+// trace on the CPU clock; the offset is re-sampled every STATS_FRAMES frames.
+static const int QLAT = 4;
+const char* passName[PASS_COUNT] = {"capture","blur","draw"};
+static GLuint queries[QLAT][PASS_COUNT];
+static bool timing=false, qPending[QLAT];
+static int qVariant[QLAT]; static unsigned qBlock[QLAT];   // A/B tag of each query set
+static double gpuSum[PASS_COUNT]; double gpuLast[PASS_COUNT]; static int gpuN=0;
+PresentLatency latency;   // also takes our per-frame GPU time, see the hooks
+static void (*glGetQueryObjectui64vEXT_)(GLuint,GLenum,GLuint64*)=0;
+static void (*glQueryCounterEXT_)(GLuint,GLenum)=0;
+static GLuint stamps[QLAT][PASS_COUNT][2];
+static bool stampable=false, stamping=false, stamped[QLAT];
+static long long gpuToCpu=0;   // CLOCK_MONOTONIC ns minus GPU timestamp ns
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+#ifndef GL_TIMESTAMP_EXT
+#define GL_TIMESTAMP_EXT 0x8E28
+#define GL_QUERY_COUNTER_BITS_EXT 0x8864
+#endif
+
+// Desktop GL 3.3 has the same queries in core (ARB_timer_query), minus the disjoint flag
+static void gpuInit(){
+    const char* e=desktop?0:(const char*)glGetString(GL_EXTENSIONS);   // an error on core profiles
+    glGetQueryObjectui64vEXT_=(void(*)(GLuint,GLenum,GLuint64*))getProc(desktop?"glGetQueryObjectui64v":"glGetQueryObjectui64vEXT");
+    if(timing || !(desktop || (e && strstr(e,"GL_EXT_disjoint_timer_query"))) || !glGetQueryObjectui64vEXT_) return;
+    glGenQueries(QLAT*PASS_COUNT,&queries[0][0]); timing=true;
+    glQueryCounterEXT_=(void(*)(GLuint,GLenum))getProc(desktop?"glQueryCounter":"glQueryCounterEXT");
+    GLint bits=0;
+    if(glQueryCounterEXT_) glGetQueryiv(GL_TIMESTAMP_EXT,GL_QUERY_COUNTER_BITS_EXT,&bits);
+    if(bits>0){ glGenQueries(QLAT*PASS_COUNT*2,&stamps[0][0][0]); stampable=true; }
+}
+
+// Sampled back to back; the GL call costs a round trip, hence only every STATS_FRAMES
+static void clockSync(){
+    GLint64 g=0; glGetInteger64v(GL_TIMESTAMP_EXT,&g);
+    gpuToCpu=(long long)traceNow()-g; trace(EV_CLOCK_SYNC);
+}
+static Pass pass;
+static void gpuBegin(Pass p){
+    trace(EV_PASS_BEGIN,pass=p);
+    if(stamping) glQueryCounterEXT_(stamps[frame%QLAT][p][0],GL_TIMESTAMP_EXT);
+    if(timing) glBeginQuery(GL_TIME_ELAPSED_EXT,queries[frame%QLAT][p]);
+}
+static void gpuEnd(){
+    if(timing) glEndQuery(GL_TIME_ELAPSED_EXT);
+    if(stamping) glQueryCounterEXT_(stamps[frame%QLAT][pass][1],GL_TIMESTAMP_EXT);
+    trace(EV_PASS_END,pass);
+}
+
+static void gpuCollect(){
+    if(!timing) return;
+    qPending[frame%QLAT]=true; stamped[frame%QLAT]=stamping;
+    qVariant[frame%QLAT]=abSample()?variant:-1; qBlock[frame%QLAT]=abBlock;
+    int old=(frame+1)%QLAT;   // the oldest set, written QLAT-1 frames ago
+    GLuint ready=0, last=1;
+    if(qPending[old]) glGetQueryObjectuiv(queries[old][PASS_DRAW],GL_QUERY_RESULT_AVAILABLE,&ready);
+    if(ready && stamped[old]) glGetQueryObjectuiv(stamps[old][PASS_DRAW][1],GL_QUERY_RESULT_AVAILABLE,&last);
+    if(ready && last){
+        GLint disjoint=0; if(!desktop) glGetIntegerv(GL_GPU_DISJOINT_EXT,&disjoint);
+        GLuint64 total=0;
+        for(int p=0;p<PASS_COUNT && !disjoint;p++){ GLuint64 ns=0; glGetQueryObjectui64vEXT_(queries[old][p],GL_QUERY_RESULT,&ns); gpuSum[p]+=ns*1e-6; gpuLast[p]=ns*1e-6; total+=ns; }
+        if(!disjoint) latency.ourGpu(total);
+        if(!disjoint && qVariant[old]>=0) abGpu.add(qVariant[old],qBlock[old],total);
+        for(int p=0;p<PASS_COUNT && !disjoint && stamped[old];p++){
+            GLuint64 b=0,e=0;
+            glGetQueryObjectui64vEXT_(stamps[old][p][0],GL_QUERY_RESULT,&b); glGetQueryObjectui64vEXT_(stamps[old][p][1],GL_QUERY_RESULT,&e);
+            traceAt(b+gpuToCpu,EV_GPU_PASS,p,(uint32_t)(e-b));
+        }
+        if(!disjoint) gpuN++;
+        qPending[old]=stamped[old]=false;
+    }
+    bool want=stampable && tracing.load(std::memory_order_relaxed);
+    if(want && (!stamping || frame%STATS_FRAMES==0)) clockSync();
+    stamping=want;
+    if(frame%STATS_FRAMES==0){
+        static_assert(PASS_COUNT==3, "one %s %.3f per pass");
+        double ms[PASS_COUNT]; for(int p=0;p<PASS_COUNT;p++){ ms[p]=gpuN?gpuSum[p]/gpuN:0.0; gpuSum[p]=0; }
+        logLater("ring %d, %.1f MB textures | %s %.3f ms %s %.3f ms %s %.3f ms",slots,texBytes/1048576.0,passName[0],ms[0],passName[1],ms[1],passName[2],ms[2]);
+        gpuN=0;
+    }
+}
+
+// Single-sample colour texture with its framebuffer
+static void target(GLuint& tx, GLuint& fb, int tw, int th, GLenum fmt=GL_RGBA8){
+    glGenTextures(1,&tx); glBindTexture(GL_TEXTURE_2D,tx);
+    glTexStorage2D(GL_TEXTURE_2D,1,fmt,tw,th);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR); glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE); glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+    glGenFramebuffers(1,&fb); glBindFramebuffer(GL_FRAMEBUFFER,fb); glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,tx,0);
+}
+
+// 1:1 blit of fbo into a single-sample target of the surface's format, as the capture resolves
+static void resolve(GLuint fbo, GLuint& tx, GLuint& fb, int w, int h){
+    if(!tx) target(tx,fb,w,h,surf.fmt);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,fbo); glBindFramebuffer(GL_DRAW_FRAMEBUFFER,fb);
+    glBlitFramebuffer(0,0,w,h,0,0,w,h,GL_COLOR_BUFFER_BIT,GL_NEAREST);
+}
+
+// Sources are written against GLSL ES 3.00; a desktop context gets glslVersion's line instead
+static GLuint compile(GLenum t, const char* s, const char* defs=""){
+    const char* src[3]={glslVersion,defs,strchr(s,'\n')};
+    GLuint x=glCreateShader(t); glShaderSource(x,3,src,0); glCompileShader(x); return x;
+}
+
+// Draw programs for the current levels and sharpen setting; on its own when only
+// sharpen turns on or off. Only level 0 is sharpened: the outer bands are upscaled
+// from 1/2 and 1/4, CAS there would sharpen the upscale and cost four extra fetches
+// per output pixel.
+static void buildDraw(){
+    glDeleteProgram(progDraw[0]); glDeleteProgram(progDraw[1]); progDraw[0]=progDraw[1]=0;
+    GLuint vo=compile(GL_VERTEX_SHADER,vert_out);
+    for(int p=0;p<(levels>1?2:1);p++){
+        GLuint fs=compile(GL_FRAGMENT_SHADER,frag_draw,p==0 && cfg.sharpen>0?"\n#define CAS 1":"\n#define CAS 0");
+        progDraw[p]=glCreateProgram(); glAttachShader(progDraw[p],vo); glAttachShader(progDraw[p],fs); glLinkProgram(progDraw[p]); glDeleteShader(fs);
+        uCbDraw[p]=glGetUniformLocation(progDraw[p],"k"); uSharpen[p]=glGetUniformLocation(progDraw[p],"a"); uRot[p]=glGetUniformLocation(progDraw[p],"R");
+        turnsSet[p]=-1;
+    }
+    glDeleteShader(vo);
+}
+
+void initGL(int w, int h) {
+    // Resource cleanup
+    if(lv[0].raw[0]){
+        for(int l=0;l<levels;l++){Level& L=lv[l]; glDeleteTextures(slots,L.raw); glDeleteFramebuffers(slots,L.rawFBO); glDeleteTextures(slots,L.hist); glDeleteFramebuffers(slots,L.histFBO); glDeleteRenderbuffers(1,&L.rb); L=Level();}
+        glDeleteVertexArrays(1,&vao); glDeleteBuffers(1,&quadVB); glDeleteBuffers(1,&quadIB); glDeleteTextures(2,maskTex); glDeleteTextures(2,moveTex); glDeleteFramebuffers(2,maskFBO);
+        glDeleteProgram(progBlur); glDeleteProgram(progMask); glDeleteProgram(progStencil); glDeleteProgram(progCopy); glDeleteProgram(progPattern);}
+    
+    // Internal Resolution
+    iW=(int)(w*cfg.scale); iH=(int)(h*cfg.scale);
+    mW=iW/MASK_DIV>1?iW/MASK_DIV:1; mH=iH/MASK_DIV>1?iH/MASK_DIV:1;
+    levels=cfg.foveaLevels<1?1:cfg.foveaLevels>3?3:cfg.foveaLevels;
+    slots=cfg.ring; texBytes=0;
+    trace(EV_RESIZE,w,h);
+
+    // Shader Compilation (each shader goes with the last program it is attached to)
+    trace(EV_COMPILE);
+    auto c=[](GLenum t, const char* s){ return compile(t,s); };
+    GLuint vs=c(GL_VERTEX_SHADER,vert), fs1=c(GL_FRAGMENT_SHADER,frag_blur);
+    
+    progBlur=glCreateProgram(); glAttachShader(progBlur,vs); glAttachShader(progBlur,fs1); glLinkProgram(progBlur);
+    glUseProgram(progBlur); glUniform1i(glGetUniformLocation(progBlur,"c"),0); glUniform1i(glGetUniformLocation(progBlur,"h"),1);
+    uCbBlur=glGetUniformLocation(progBlur,"k");
+
+    buildDraw();
+
+    GLuint fs3=c(GL_FRAGMENT_SHADER,frag_mask), fs4=c(GL_FRAGMENT_SHADER,frag_stencil), fs5=c(GL_FRAGMENT_SHADER,frag_copy);
+    progMask=glCreateProgram(); glAttachShader(progMask,vs); glAttachShader(progMask,fs3); glLinkProgram(progMask);
+    glUseProgram(progMask); glUniform1i(glGetUniformLocation(progMask,"c"),0); glUniform1i(glGetUniformLocation(progMask,"h"),1);
+    glUniform1i(glGetUniformLocation(progMask,"g"),2);
+    glUniform1f(glGetUniformLocation(progMask,"r"),1.0f/MASK_FRAMES); glUniform1f(glGetUniformLocation(progMask,"q"),MASK_MOTION);
+    progStencil=glCreateProgram(); glAttachShader(progStencil,vs); glAttachShader(progStencil,fs4); glLinkProgram(progStencil);
+    progCopy=glCreateProgram(); glAttachShader(progCopy,vs); glAttachShader(progCopy,fs5); glLinkProgram(progCopy);
+    GLuint fs6=c(GL_FRAGMENT_SHADER,frag_pattern);
+    progPattern=glCreateProgram(); glAttachShader(progPattern,vs); glAttachShader(progPattern,fs6); glLinkProgram(progPattern);
+    for(GLuint x:{vs,fs1,fs3,fs4,fs5,fs6}) glDeleteShader(x);
+    
+    // Geometry Setup
+    GLfloat d[]={-1,1,0,1, -1,-1,0,0, 1,-1,1,0, 1,1,1,1}; GLushort i[]={0,1,2, 0,2,3};
+    glGenVertexArrays(1,&vao); glBindVertexArray(vao);
+    glGenBuffers(1,&quadVB); glBindBuffer(GL_ARRAY_BUFFER,quadVB); glBufferData(GL_ARRAY_BUFFER,sizeof(d),d,GL_STATIC_DRAW);
+    glGenBuffers(1,&quadIB); glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,quadIB); glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(i),i,GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0); glVertexAttribPointer(0,2,GL_FLOAT,0,16,0); glEnableVertexAttribArray(1); glVertexAttribPointer(1,2,GL_FLOAT,0,16,(void*)8);
+
+    // Texture Setup
+    for(int l=0;l<levels;l++){
+        Level& L=lv[l]; L.w=(iW>>l)>1?iW>>l:1; L.h=(iH>>l)>1?iH>>l:1;
+        for(int k=0;k<slots;k++){ target(L.raw[k],L.rawFBO[k],L.w,L.h,redirect?GL_RGBA8:surf.fmt); target(L.hist[k],L.histFBO[k],L.w,L.h); }
+        texBytes+=(size_t)L.w*L.h*4*2*slots;
+        // Stencil: bit 0 = UI mask (per frame), bit 1 = checkerboard parity (fixed)
+        if(UI_MASK || cfg.checkerboard){
+            glGenRenderbuffers(1,&L.rb); glBindRenderbuffer(GL_RENDERBUFFER,L.rb); glRenderbufferStorage(GL_RENDERBUFFER,GL_STENCIL_INDEX8,L.w,L.h);
+            for(int k=0;k<slots;k++){glBindFramebuffer(GL_FRAMEBUFFER,L.histFBO[k]); glFramebufferRenderbuffer(GL_FRAMEBUFFER,GL_STENCIL_ATTACHMENT,GL_RENDERBUFFER,L.rb);}
+            texBytes+=(size_t)L.w*L.h;
+            glViewport(0,0,L.w,L.h); glStencilMask(0xFF); glClearStencil(0); glClear(GL_STENCIL_BUFFER_BIT);
+            if(cfg.checkerboard){
+                glEnable(GL_STENCIL_TEST); glStencilFunc(GL_ALWAYS,2,0xFF); glStencilOp(GL_KEEP,GL_KEEP,GL_REPLACE); glStencilMask(2);
+                glColorMask(0,0,0,0); glUseProgram(progPattern); glBindVertexArray(vao); glDrawElements(GL_TRIANGLES,6,GL_UNSIGNED_SHORT,0);
+                glColorMask(1,1,1,1); glStencilOp(GL_KEEP,GL_KEEP,GL_KEEP); glStencilMask(0xFF); glDisable(GL_STENCIL_TEST);
+            }
+        }
+    }
+
+    // UI Mask (cleared to "unstable", so a resize relearns it from scratch). Its pass also
+    // writes a change map whose last mip level gates learning on scene motion.
+    if(UI_MASK){
+        target(maskTex[0],maskFBO[0],mW,mH); target(maskTex[1],maskFBO[1],mW,mH);
+        for(moveTop=0;(mW>mH?mW:mH)>>moveTop>1;moveTop++){}
+        texBytes+=(size_t)mW*mH*4*2+(size_t)mW*mH*2*4/3;
+        glGenTextures(2,moveTex);
+        for(int k=0;k<2;k++){
+            glBindTexture(GL_TEXTURE_2D,moveTex[k]); glTexStorage2D(GL_TEXTURE_2D,moveTop+1,GL_R8,mW,mH);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST_MIPMAP_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER,maskFBO[k]); glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT1,GL_TEXTURE_2D,moveTex[k],0);
+            static const GLenum both[2]={GL_COLOR_ATTACHMENT0,GL_COLOR_ATTACHMENT1}; glDrawBuffers(2,both);
+            glClearColor(0,0,0,0); glClear(GL_COLOR_BUFFER_BIT); glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        glUseProgram(progMask); glUniform1f(glGetUniformLocation(progMask,"top"),(float)moveTop);
+    }
+
+    // Capture Path (the redirected game target is always plain RGBA8)
+    if(resolveTex){glDeleteTextures(1,&resolveTex); glDeleteFramebuffers(1,&resolveFBO); resolveTex=resolveFBO=0;}
+    capture = redirect || surf.samples<=1 ? CAP_BLIT : lv[0].w==w && lv[0].h==h && levels==1 ? CAP_RESOLVE : CAP_RESOLVE_DOWN;
+    if(capture==CAP_RESOLVE_DOWN){ target(resolveTex,resolveFBO,w,h,surf.fmt); texBytes+=(size_t)w*h*4; }
+    if(readTex){glDeleteTextures(1,&readTex); glDeleteFramebuffers(1,&readFBO); readTex=readFBO=0;}
+    built=surf;
+    logLater("capture: %s, %d samples, format 0x%x",capture==CAP_BLIT?"blit":capture==CAP_RESOLVE?"resolve":"resolve+downscale",surf.samples,surf.fmt);
+
+    // Game Render Target (replaces the default framebuffer while GAME_SCALE < 1)
+    if(gameTex){glDeleteTextures(1,&gameTex); glDeleteFramebuffers(1,&gameFBO); glDeleteRenderbuffers(1,&gameRB); gameTex=gameFBO=gameRB=0;}
+    if(redirect){
+        gW=(int)(w*gameScale); gH=(int)(h*gameScale);
+        glGenTextures(1,&gameTex); glBindTexture(GL_TEXTURE_2D,gameTex);
+        glTexStorage2D(GL_TEXTURE_2D,1,GL_RGBA8,gW,gH);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR); glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+        glGenRenderbuffers(1,&gameRB); glBindRenderbuffer(GL_RENDERBUFFER,gameRB); glRenderbufferStorage(GL_RENDERBUFFER,GL_DEPTH24_STENCIL8,gW,gH);
+        glGenFramebuffers(1,&gameFBO); glBindFramebuffer(GL_FRAMEBUFFER,gameFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,gameTex,0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER,GL_DEPTH_STENCIL_ATTACHMENT,GL_RENDERBUFFER,gameRB);
+        glClearColor(0,0,0,1); glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT|GL_STENCIL_BUFFER_BIT);
+        texBytes+=(size_t)gW*gH*8;
+    }
+    
+    // Clear Buffers
+    for(int l=0;l<levels;l++) for(int k=0;k<slots;k++){glBindFramebuffer(GL_FRAMEBUFFER,lv[l].histFBO[k]); glClearColor(0,0,0,1); glClear(GL_COLOR_BUFFER_BIT);}
+    gpuInit();
+    sW=w; sH=h;
+    for(Rect& r:decay) r={0,0,w,h};   // fresh history: everything is unsettled
+    seed=true;
+}
+
+// =============================================================
+// 3b. MASK + FOVEA GEOMETRY
+// =============================================================
+// The centre mask is geometry, not math: rays from the screen centre are cut at
+// the mask radii and the screen edge, and each vertex carries its precomputed
+// smoothstep weight. The blur draws the ring + outside; the protected core is a
+// plain copy. Rays every 7.5 degrees include the screen corners (45, 135, ...).
+// Fovea levels cut the same rays at nested rectangles, so every band lines up.
+void buildMesh(int w, int h){
+    const int RAYS=48, RINGS=6;
+    float aspect=(float)w/h;
+    for(int l=0;l<levels;l++) ext[l]=powf(cfg.foveaSize,(float)(levels-1-l));
+    margin=levels>1?0.03f:0.0f;   // levels process a little past their band so filtering at the seam reads valid texels
+    auto rect=[](float e){ e=fminf(fmaxf(e,0.0f),1.0f); return [e](float dx, float dy){ return 0.5f*e/fmaxf(fabsf(dx),fabsf(dy)); }; };
+    auto edge=rect(ext[0]+margin);
+    auto rad=[&](float r, float dx, float dy){
+        float t = cfg.maskShape==MASK_CIRCLE ? r/sqrtf(dx*dx*aspect*aspect+dy*dy) : r;
+        return fminf(t,edge(dx,dy));
+    };
+    std::vector<float> v;
+    auto put=[&](float dx, float dy, float t, float wt){
+        float u=0.5f+dx*t, s=0.5f+dy*t;
+        v.insert(v.end(),{u*2-1, s*2-1, u, s, wt});
+    };
+    auto band=[&](auto t0, auto t1, float w0, float w1){
+        for(int j=0;j<RAYS;j++){
+            float a0=j*6.2831853f/RAYS, a1=(j+1)*6.2831853f/RAYS;
+            float x0=cosf(a0), y0=sinf(a0), x1=cosf(a1), y1=sinf(a1);
+            put(x0,y0,t0(x0,y0),w0); put(x1,y1,t0(x1,y1),w0); put(x1,y1,t1(x1,y1),w1);
+            put(x0,y0,t0(x0,y0),w0); put(x1,y1,t1(x1,y1),w1); put(x0,y0,t1(x0,y0),w1);
+        }
+    };
+    auto mark=[&](Range& r, auto emit){ r.first=(GLint)(v.size()/5); emit(); r.count=(GLint)(v.size()/5)-r.first; };
+
+    float r0=cfg.maskInner, r1=cfg.maskOuter;
+    mark(ringR,[&]{
+        for(int i=0;i<RINGS;i++){
+            float a=r0+(r1-r0)*i/RINGS, b=r0+(r1-r0)*(i+1)/RINGS;
+            auto sm=[&](float r){ float x=(r-r0)/(r1-r0+1e-6f); return x*x*(3-2*x); };
+            band([&](float x,float y){return rad(a,x,y);}, [&](float x,float y){return rad(b,x,y);}, sm(a), sm(b));
+        }
+        band([&](float x,float y){return rad(r1,x,y);}, edge, 1.0f, 1.0f);
+    });
+    mark(coreR,[&]{ band([](float,float){return 0.0f;}, [&](float x,float y){return rad(r0,x,y);}, 0.0f, 0.0f); });
+    mark(bandR[0],[&]{ band([](float,float){return 0.0f;}, rect(ext[0]), 1.0f, 1.0f); });
+    mark(procR[0],[&]{ band([](float,float){return 0.0f;}, edge, 1.0f, 1.0f); });
+    for(int l=1;l<levels;l++){
+        mark(bandR[l],[&]{ band(rect(ext[l-1]), rect(ext[l]), 1.0f, 1.0f); });
+        mark(procR[l],[&]{ band(rect(ext[l-1]-margin), rect(ext[l]+margin), 1.0f, 1.0f); });
+    }
+
+    if(!meshVAO){
+        glGenVertexArrays(1,&meshVAO); glBindVertexArray(meshVAO);
+        glGenBuffers(1,&meshVB); glBindBuffer(GL_ARRAY_BUFFER,meshVB);
+        glEnableVertexAttribArray(0); glVertexAttribPointer(0,2,GL_FLOAT,0,20,0);
+        glEnableVertexAttribArray(1); glVertexAttribPointer(1,2,GL_FLOAT,0,20,(void*)8);
+        glEnableVertexAttribArray(2); glVertexAttribPointer(2,1,GL_FLOAT,0,20,(void*)16);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER,meshVB); glBufferData(GL_ARRAY_BUFFER,v.size()*4,v.data(),GL_STATIC_DRAW);
+
+    // Shaded pixels per frame, measured on the mesh actually drawn (margins included)
+    auto px=[&](Range r, int tw, int th){
+        double a=0;
+        for(GLint i=r.first;i<r.first+r.count;i+=3){
+            const float *p=&v[i*5], *q=&v[i*5+5], *u=&v[i*5+10];
+            a+=fabs((q[0]-p[0])*(u[1]-p[1])-(u[0]-p[0])*(q[1]-p[1]))/8;   // NDC spans 2x2
+        }
+        return a*tw*th;
+    };
+    double blur=0, out=0, sharp=cfg.sharpen>0?px(bandR[0],w,h):0;
+    for(int l=0;l<levels;l++){ blur+=px(procR[l],lv[l].w,lv[l].h); out+=px(bandR[l],w,h); }
+    if(levels>1) logLater("fovea: %d levels, %.2f Mpx shaded per frame (blur %.2f + draw %.2f, %.0f%% of unfoveated), %.0f%% of the output sharpened",
+        levels,(blur+out)/1e6,blur/1e6,out/1e6,100*(blur+out)/((double)iW*iH+(double)w*h),100*sharp/((double)w*h));
+}
+
+void render(int w, int h, bool mask, const Rect* damage) {
+    bool changed = config.version()!=cfgVer;
+    if(changed){ cfgVer=config.version(); cfgBase=config.load(); trace(EV_CONFIG); }
+    if(abConfig.version()!=abVer){ abVer=abConfig.version(); ab=abConfig.load(); abGpu.reset(); abHook.reset(); abSwap.reset(); abStart=frame; changed=true; }
+    if(changed && ab.every>0){   // variants that rebuild on every flip get the longer warm-up
+        Config a=cfgBase, b=cfgBase; applyKeys(a,ab.over[0]); applyKeys(b,ab.over[1]);
+        Governor::apply(a,govSeen); Governor::apply(b,govSeen);
+        abWarmup=abWarmupFor(a,b);
+        if(ab.every<2*abWarmup){ logLater("A/B off: these variants rebuild on every flip, blocks need %d frames or more",2*abWarmup); ab.every=0; }
+    }
+    unsigned at=frame-abStart;
+    int v=ab.every>0 ? (int)(at/ab.every)&1 : -1;
+    abBlock=ab.every>0 ? at/ab.every : 0; abPos=ab.every>0 ? at%ab.every : 0;
+    if(v!=variant){ variant=v; changed=true; }
+    int gov=governorLevel.load(std::memory_order_relaxed);
+    if(gov!=govSeen){ govSeen=gov; changed=true; }
+    if(changed){
+        Config old=cfg; cfg=cfgBase;
+        if(variant>=0) applyKeys(cfg,ab.over[variant]);
+        Governor::apply(cfg,gov);
+        if(!sameTextures(cfg,old)) sW=0;   // different textures needed
+        else if((cfg.sharpen>0)!=(old.sharpen>0) && progDraw[0]) buildDraw();   // only the draw program changes
+    }
+    bool resized = w!=sW || h!=sH || !lv[0].raw[0] || surf.samples!=built.samples || surf.fmt!=built.fmt;
+    if(resized) initGL(w,h);
+    if(resized || changed) buildMesh(w,h);
+    if(changed) for(Rect& r:decay) r={0,0,w,h};
+
+    // Damage: capture only what the game redrew (elsewhere the surface may already hold
+    // our own output from an older frame), process that plus everything still fading.
+    Rect full={0,0,w,h}, D=damage?meet(*damage,full):full;
+    Rect P=meet(unite(D,decayRegion()),full);
+    // Output: the whole surface, unless the buffer still holds our own output around P
+    // (preserved, or a buffer age from eglSetDamageRegionKHR): then only P and what
+    // changed since that buffer was last shown
+    Rect O=bufferAge>0 && bufferAge<=DECAY_FRAMES ? meet(unite(P,repairRegion(bufferAge)),full) : full;
+    decay[decayAt%DECAY_FRAMES]=D; shown[decayAt++%DECAY_FRAMES]=P; processed=P;
+    // A rotated capture slot was last written slots-1 frames ago: refresh all damage since
+    Rect C=D; for(int k=1;k<slots;k++) C=unite(C,decay[(decayAt-1-k+DECAY_FRAMES)%DECAY_FRAMES]);
+    int cur=frame%slots, pre=(cur+slots-1)%slots, mc=frame&1, mp=mc^1;
+    auto scissor=[&](Rect r, int tw, int th){
+        glEnable(GL_SCISSOR_TEST);
+        int x0=r.x0*tw/w, y0=r.y0*th/h, x1=(r.x1*tw+w-1)/w, y1=(r.y1*th+h-1)/h;
+        glScissor(x0,y0,x1-x0,y1-y0);
+    };
+    auto clip=[&](Rect r, int tw, int th){ if(r.x0>0 || r.y0>0 || r.x1<w || r.y1<h) scissor(r,tw,th); else glDisable(GL_SCISSOR_TEST); };
+    
+    // Save state is not strictly required for SwapBuffers hooks on Android, 
+    // but disabling tests is crucial for our full-screen pass.
+    glDisable(GL_SCISSOR_TEST); glDisable(GL_DEPTH_TEST); glDisable(GL_BLEND); glDisable(GL_STENCIL_TEST);
+
+    // 1. FAST COPY (Downscale) - from the reduced game target when the game is redirected
+    // Each level only needs its own rectangle of the screen
+    gpuBegin(PASS_CAPTURE);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,gameFBO?gameFBO:inputFBO);
+    if(capture==CAP_RESOLVE_DOWN){
+        // One 1:1 resolve of what changed, every level downsamples from that
+        if(C.x0>0 || C.y0>0 || C.x1<w || C.y1<h) scissor(C,w,h);
+        resolve(inputFBO,resolveTex,resolveFBO,w,h);
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER,resolveFBO);
+    }
+    for(int l=0;l<levels;l++){
+        Level& L=lv[l];
+        float e=fminf(ext[l]+margin,1.0f);
+        int x=(int)(w*(1-e)*0.5f), y=(int)(h*(1-e)*0.5f);
+        Rect c=meet(C,{x,y,w-x,h-y});
+        if(c.empty()) continue;
+        if(e<1.0f || c.x0>0 || c.y0>0 || c.x1<w || c.y1<h) scissor(c,L.w,L.h);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER,L.rawFBO[cur]);
+        glBlitFramebuffer(0,0,gameFBO?gW:w,gameFBO?gH:h,0,0,L.w,L.h,GL_COLOR_BUFFER_BIT,capture==CAP_RESOLVE?GL_NEAREST:GL_LINEAR);
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    gpuEnd();
+    if(captureTap){
+        // The source holds the whole frame: what changed was just refreshed, the rest is unchanged
+        CaptureInfo ci={gameFBO?gameFBO:inputFBO,gW,gH,w,h,D,mask};
+        if(capture==CAP_RESOLVE_DOWN) ci={resolveFBO,w,h,w,h,D,mask};
+        else if(capture==CAP_RESOLVE) ci={lv[0].rawFBO[cur],w,h,w,h,D,mask};
+        else if(!gameFBO) ci.fw=w, ci.fh=h;
+        captureTap(ci);
+    }
+    gpuBegin(PASS_BLUR);
+    bool ui=UI_MASK && mask;   // pre-HUD captures have nothing to mask
+    glBindVertexArray(vao);
+
+    // 2a. UI MASK UPDATE (tiny) + STENCIL MARK
+    if(ui){
+        glBindFramebuffer(GL_FRAMEBUFFER,maskFBO[mc]); glViewport(0,0,mW,mH);
+        glUseProgram(progMask);
+        glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D,lv[levels-1].raw[cur]);
+        glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_2D,maskTex[mp]);
+        glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_2D,moveTex[mp]);
+        glDrawElements(GL_TRIANGLES,6,GL_UNSIGNED_SHORT,0);
+        glBindTexture(GL_TEXTURE_2D,moveTex[mc]); glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    auto mark=[&](){
+        glStencilMask(1); glClearStencil(0); glClear(GL_STENCIL_BUFFER_BIT);
+        glEnable(GL_STENCIL_TEST); glStencilFunc(GL_ALWAYS,1,0xFF); glStencilOp(GL_KEEP,GL_KEEP,GL_REPLACE);
+        glColorMask(0,0,0,0); glUseProgram(progStencil);
+        glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D,maskTex[mc]);
+        glBindVertexArray(vao); glDrawElements(GL_TRIANGLES,6,GL_UNSIGNED_SHORT,0);
+        glColorMask(1,1,1,1); glStencilOp(GL_KEEP,GL_KEEP,GL_KEEP);
+    };
+    auto draw=[&](Range r){ glBindVertexArray(meshVAO); glDrawArrays(GL_TRIANGLES,r.first,r.count); };
+
+    // 2b. BLUR PASS (HUD pixels and the crosshair core get a plain copy of the current frame instead)
+    // Checkerboard: only one parity field is blurred, the other keeps its previous result.
+    // The stale field lags a frame: moving edges comb for as long as the scene moves
+    // (the draw pass clamp only helps inside flat areas) and clear on the first still
+    // frame. tests/checkerboard_quality measures it against the full blur.
+    // After a rebuild (resize, governor step, ...) the history starts as a copy of the
+    // capture rather than blending in from black.
+    bool cb=cfg.checkerboard;
+    GLint field=cb?(frame&1)*2:0, bits=(ui?1:0)|(cb?2:0);
+    for(int l=0;l<levels;l++){
+        Level& L=lv[l];
+        glBindFramebuffer(GL_FRAMEBUFFER,L.histFBO[cur]); glViewport(0,0,L.w,L.h); clip(P,L.w,L.h);
+        if(seed){
+            glUseProgram(progCopy); glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D,L.raw[cur]);
+            if(levels==1){ glBindVertexArray(vao); glDrawElements(GL_TRIANGLES,6,GL_UNSIGNED_SHORT,0); } else draw(procR[l]);
+            continue;
+        }
+        if(ui) mark();
+        if(bits){ glEnable(GL_STENCIL_TEST); glStencilFunc(GL_EQUAL,field,bits); }
+        glUseProgram(progBlur); glUniform1f(uCbBlur,cb?1.0f:0.0f);
+        glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D,L.raw[cur]);
+        glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_2D,L.hist[pre]);
+        bool centre=l==0 && mask && cfg.maskShape!=MASK_NONE;
+        if(centre) draw(ringR);
+        else if(levels==1){ glVertexAttrib1f(2,1.0f); glBindVertexArray(vao); glDrawElements(GL_TRIANGLES,6,GL_UNSIGNED_SHORT,0); }
+        else draw(procR[l]);
+        glUseProgram(progCopy);
+        if(cb){
+            glStencilFunc(GL_EQUAL,2-field,bits);
+            glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D,L.hist[pre]);
+            draw(procR[l]);
+            glBindTexture(GL_TEXTURE_2D,L.raw[cur]);
+        }
+        if(centre){ if(bits) glStencilFunc(GL_EQUAL,0,ui?1:0); draw(coreR); }
+        if(ui){ glStencilFunc(GL_EQUAL,1,1); draw(procR[l]); }
+        if(bits) glDisable(GL_STENCIL_TEST);
+    }
+    seed=false;
+
+    gpuEnd();
+
+    // 3. DRAW PASS (Upscale + Sharpen, always to the real surface)
+    gpuBegin(PASS_DRAW);
+    // HUD pixels keep the game's own native-resolution output when the surface has stencil
+    // Pre-rotated: the surface is (h,w) and everything above stayed in the game's orientation
+    glBindFramebuffer(GL_FRAMEBUFFER,outputFBO);
+    if(turns&1) glViewport(0,0,h,w); else { glViewport(0,0,w,h); clip(O,w,h); }
+    bool keep=ui && surf.stencil && !gameFBO && !outputFBO;
+    if(keep){ mark(); glStencilFunc(GL_EQUAL,0,1); }
+    static const GLfloat R[4][4]={{1,0,0,1},{0,-1,1,0},{-1,0,0,-1},{0,1,-1,0}};
+    glActiveTexture(GL_TEXTURE0);
+    for(int l=0;l<levels;l++){
+        if(l<2){   // level 0 sharpened, the outer bands share the plain variant
+            glUseProgram(progDraw[l]); glUniform1f(uCbDraw[l],cb?1.0f:0.0f); glUniform1f(uSharpen[l],cfg.sharpen);
+            if(turnsSet[l]!=turns){ glUniformMatrix2fv(uRot[l],1,GL_FALSE,R[turns]); turnsSet[l]=turns; }
+        }
+        glBindTexture(GL_TEXTURE_2D,lv[l].hist[cur]); draw(bandR[l]);
+    }
+    if(keep) glDisable(GL_STENCIL_TEST);
+    // The stencil write mask goes back to its default rather than a per-frame glGet of
+    // the game's: the game sets its own each frame, callers that keep state restore it
+    glStencilMask(0xFF); glDisable(GL_SCISSOR_TEST);
+    gpuEnd();
+    gpuCollect();
+    if(variant>=0 && frame%STATS_FRAMES==0) abPublish();
+    frame++;
+}
+
+void bindReadable(int w, int h){
+    if(surf.samples<=1){ glBindFramebuffer(GL_READ_FRAMEBUFFER,outputFBO); return; }
+    if(readTex && (w!=readW || h!=readH)){ glDeleteTextures(1,&readTex); glDeleteFramebuffers(1,&readFBO); readTex=readFBO=0; }
+    readW=w; readH=h;
+    GLboolean sc=glIsEnabled(GL_SCISSOR_TEST); glDisable(GL_SCISSOR_TEST);
+    resolve(outputFBO,readTex,readFBO,w,h);
+    if(sc) glEnable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,readFBO);
+}
+
+FrameTextures frameTextures(){
+    if(!frame || !lv[0].raw[0]) return {0,0,0,0,0,levels};
+    int cur=(frame-1)%slots;
+    return {frame,lv[0].raw[cur],lv[0].hist[cur],lv[0].w,lv[0].h,levels};
+}
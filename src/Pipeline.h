@@ -0,0 +1,89 @@
+#pragma once
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <atomic>
+#include "Config.h"
+#include "Latency.h"
+#include "AbTest.h"
+
+// =============================================================
+// PIPELINE: capture, blur and sharpen (platform-agnostic GLES3)
+// =============================================================
+// render() runs with the game's context current and leaves the result in
+// framebuffer 0. The hook layer (main.cpp) owns everything platform-specific;
+// the host tools link this file against Mesa to replay captured workloads.
+
+// Damage rectangles are in surface pixels, bottom-left origin (EGL and GL agree).
+struct Rect { int x0, y0, x1, y1; bool empty() const { return x1<=x0 || y1<=y0; } };
+inline Rect unite(Rect a, Rect b){ if(a.empty()) return b; if(b.empty()) return a; return {a.x0<b.x0?a.x0:b.x0, a.y0<b.y0?a.y0:b.y0, a.x1>b.x1?a.x1:b.x1, a.y1>b.y1?a.y1:b.y1}; }
+inline Rect meet(Rect a, Rect b){ return {a.x0>b.x0?a.x0:b.x0, a.y0>b.y0?a.y0:b.y0, a.x1<b.x1?a.x1:b.x1, a.y1<b.y1?a.y1:b.y1}; }
+inline Rect bbox(const EGLint* r, EGLint n){ Rect u={0,0,0,0}; for(int i=0;i<n;i++) u=unite(u,{r[4*i],r[4*i+1],r[4*i+2]+r[4*i],r[4*i+3]+r[4*i+1]}); return u; }
+
+// Capture path, decided per surface from its EGL config (see surfaceInfo):
+// a multisampled surface can only be blitted 1:1 (a resolve), and a blit into a
+// different format takes the driver's slow conversion path. A shader resolve is
+// not an option: the default framebuffer cannot be sampled.
+enum Capture { CAP_BLIT, CAP_RESOLVE, CAP_RESOLVE_DOWN };
+struct SurfaceInfo { EGLSurface s; int samples; GLenum fmt; int stencil; };   // stencil: bits of the surface's own buffer (EGL_STENCIL_SIZE)
+
+enum Pass { PASS_CAPTURE, PASS_BLUR, PASS_DRAW, PASS_COUNT };
+static const int STATS_FRAMES = 300;
+
+// State the hook layer reads or steers
+extern SurfaceInfo surf;                        // current surface (set by the hook before render)
+extern Config cfg;                              // what this frame runs with (config + A/B overlay)
+extern int turns;                               // quarter turns applied by the output pass
+extern bool redirect;                           // the game draws into gameFBO (GAME_SCALE < 1)
+extern float gameScale;                         // gameFBO size over the surface: GAME_SCALE (the host tests pick their own)
+extern GLuint gameFBO;
+extern int sW, sH, gW, gH, levels, slots, capture;
+extern unsigned frame;
+extern size_t texBytes;
+extern Rect processed;                          // last processed area
+extern double gpuLast[PASS_COUNT];
+extern const char* passName[PASS_COUNT];
+extern PresentLatency latency;
+extern std::atomic<int> governorLevel;         // quality governor level, applied over config and A/B (Governor::apply)
+
+// Context flavour, set before the first render(). Desktop GL 3.3 takes the same
+// shaders under "#version 330 core" (precision qualifiers are accepted and ignored).
+extern const char* glslVersion;                 // "#version 300 es" by default
+extern bool desktop;                            // desktop GL: core timer queries, no disjoint flag
+extern void* (*getProc)(const char*);           // eglGetProcAddress by default
+
+// A/B: the variant on screen (-1 = off), where this frame sits in its block and
+// how many of the block's first frames aren't measured (abWarmupFor, Config.h)
+extern int variant, abPos, abWarmup;
+extern unsigned abBlock;
+extern AbMetric abGpu, abHook, abSwap;          // our GPU passes, our CPU time per present, swap interval
+extern const char* abName[3];
+struct AbSummary { int every; struct { double a,b,d,ci,p50[2],p99[2]; int na,nb; bool ok; } m[3]; };   // ms; p50/p99 per frame
+extern Seqlock<AbSummary> abSummary;
+inline bool abSample(){ return variant>=0 && abPos>=abWarmup; }
+
+// Called once per processed frame right after the capture pass, while the
+// complete game image is still readable: fbo holds it at fw x fh (the surface
+// is w x h). No-op unless set.
+struct CaptureInfo { GLuint fbo; int fw, fh, w, h; Rect damage; bool mask; };
+extern void (*captureTap)(const CaptureInfo& c);
+
+// Embedding (MotionBlur.h): render() reads inputFBO and writes outputFBO instead
+// of the default framebuffer (0 = default; gameFBO still wins while redirected)
+extern GLuint inputFBO, outputFBO;
+// Level 0 of the last processed frame: the downscaled capture and the blurred
+// history the output pass upscaled. Valid until the ring slot comes round again.
+struct FrameTextures { unsigned frame; GLuint capture, history; int w, h, levels; };
+FrameTextures frameTextures();
+// Binds w x h of the finished output (outputFBO) for glReadPixels: a multisampled
+// surface can't be read directly, so it is resolved into a target of our own first
+void bindReadable(int w, int h);
+
+void initGL(int w, int h);
+void buildMesh(int w, int h);
+void render(int w, int h, bool mask=true, const Rect* damage=0);
+Rect decayRegion();   // everything damaged within DECAY_FRAMES, grown by what the filters read around it
+Rect repairRegion(int age);   // processed in the last age-1 frames: stale in a buffer of that age
+// Frames since the surface's back buffer last held our output, set before render():
+// 1 = EGL_BUFFER_PRESERVED, N = EGL_BUFFER_AGE_EXT of a game using eglSetDamageRegionKHR,
+// 0 = unknown (the game redraws everything, so the draw pass covers the whole surface)
+extern int bufferAge;
@@ -0,0 +1,140 @@
+#include "PresentChain.h"
+#include <GLES3/gl3.h>
+#include <dlfcn.h>
+#include <link.h>
+#include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "Log.h"
+#include "GLState.h"
+
+// =============================================================
+// 1. REGISTRY
+// =============================================================
+static const int MAX_EFFECTS = 16;
+
+struct Entry { int id; PresentEffect e; };
+static pthread_mutex_t lock=PTHREAD_MUTEX_INITIALIZER;
+static Entry entries[MAX_EFFECTS];
+static int count=0, nextId=1;
+static std::atomic<bool> enabled{false};
+
+static int add(const PresentEffect* e){
+    if(!e || e->size<sizeof(unsigned) || !e->run) return 0;
+    Entry n={0,{}};
+    memcpy(&n.e,e,std::min<size_t>(e->size,sizeof(PresentEffect))); n.e.size=sizeof(PresentEffect);
+    pthread_mutex_lock(&lock);
+    int id=0;
+    if(count<MAX_EFFECTS){
+        id=n.id=nextId++;
+        // Sorted by order, registration order within one
+        int i=count;
+        while(i>0 && entries[i-1].e.order>n.e.order){ entries[i]=entries[i-1]; i--; }
+        entries[i]=n; count++;
+    }
+    pthread_mutex_unlock(&lock);
+    if(id) LOG("chain: + %s (order %d)",n.e.name?n.e.name:"?",n.e.order);
+    else LOG("chain: full, %s not added",n.e.name?n.e.name:"?");
+    return id;
+}
+
+static void remove(int id){
+    pthread_mutex_lock(&lock);
+    for(int i=0;i<count;i++) if(entries[i].id==id){
+        std::copy(entries+i+1,entries+count,entries+i); count--;
+        break;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+// =============================================================
+// 2. RUN
+// =============================================================
+// Two textures at most: effect k writes tex[k&1] and the next one reads it.
+// Only allocated once a second effect (or one that can't read the surface)
+// shows up, so a chain of just us costs nothing.
+static GLuint tex[2]={0,0}, fbo[2]={0,0};
+static int texW=0, texH=0;
+
+static void target(int i, int w, int h){
+    if(w!=texW || h!=texH){
+        glDeleteTextures(2,tex); glDeleteFramebuffers(2,fbo);
+        tex[0]=tex[1]=fbo[0]=fbo[1]=0; texW=w; texH=h;
+    }
+    if(tex[i]) return;
+    glGenTextures(1,&tex[i]); glBindTexture(GL_TEXTURE_2D,tex[i]);
+    glTexStorage2D(GL_TEXTURE_2D,1,GL_RGBA8,w,h);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+    glGenFramebuffers(1,&fbo[i]); glBindFramebuffer(GL_FRAMEBUFFER,fbo[i]);
+    glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,tex[i],0);
+}
+
+static int run(void* display, void* surface, int w, int h, const int* damage){
+    Entry list[MAX_EFFECTS]; int n;
+    pthread_mutex_lock(&lock);
+    n=count; std::copy(entries,entries+n,list);
+    pthread_mutex_unlock(&lock);
+    if(!n || w<=0 || h<=0) return 0;
+
+    bool keep=true;
+    for(int k=0;k<n;k++) keep&=(list[k].e.flags&PRESENT_KEEPS_STATE)!=0;
+    GLState st; if(!keep) st.save();
+
+    int src=-1;   // -1 = the surface
+    for(int k=0;k<n;k++){
+        const PresentEffect& e=list[k].e;
+        if(src<0 && !(e.flags&PRESENT_READS_SURFACE)){
+            target(0,w,h);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER,0); glBindFramebuffer(GL_DRAW_FRAMEBUFFER,fbo[0]);
+            GLboolean sc=glIsEnabled(GL_SCISSOR_TEST); glDisable(GL_SCISSOR_TEST);   // the app's scissor would clip the copy
+            glBlitFramebuffer(0,0,w,h,0,0,w,h,GL_COLOR_BUFFER_BIT,GL_NEAREST);
+            if(sc) glEnable(GL_SCISSOR_TEST);
+            src=0;
+        }
+        int dst=k==n-1 ? -1 : src==0 ? 1 : 0;
+        if(dst>=0) target(dst,w,h);
+        PresentTarget t={sizeof(PresentTarget),w,h,
+                         src<0?0u:fbo[src],src<0?0u:tex[src],dst<0?0u:fbo[dst],
+                         src<0 && dst<0 ? damage : 0,display,surface};
+        e.run(&t,e.user);
+        src=dst;
+    }
+
+    if(!keep) st.restore();
+    return n;
+}
+
+// =============================================================
+// 3. HOST ELECTION
+// =============================================================
+static PresentChain local={sizeof(PresentChain),PRESENT_CHAIN_VERSION,add,remove,run};
+
+extern "C" __attribute__((visibility("default"))) PresentChain* present_chain_v1(void){
+    return enabled.load(std::memory_order_acquire)?&local:0;
+}
+
+void presentChainEnable(bool on){ enabled.store(on,std::memory_order_release); }
+PresentChain* presentChainLocal(){ return &local; }
+
+// First library in load order whose present_chain_v1 answers (we are in that list too)
+PresentChain* presentChainFind(){
+    PresentChain* found=0;
+    dl_iterate_phdr([](dl_phdr_info* info, size_t, void* out)->int{
+        if(!info->dlpi_name || !info->dlpi_name[0]) return 0;
+        void* h=dlopen(info->dlpi_name,RTLD_NOW|RTLD_NOLOAD);
+        if(!h) return 0;
+        PresentChainFn fn=(PresentChainFn)dlsym(h,PRESENT_CHAIN_SYMBOL);
+        PresentChain* c=fn?fn():0;
+        dlclose(h);
+        if(!c || c->size<sizeof(PresentChain) || c->version<1) return 0;
+        *(PresentChain**)out=c;
+        return 1;
+    },&found);
+    if(found && found!=&local) LOG("chain: joining the host's present chain");
+    return found;
+}
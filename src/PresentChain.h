@@ -0,0 +1,82 @@
+#ifndef PRESENT_CHAIN_H
+#define PRESENT_CHAIN_H
+
+/* =============================================================
+ * PRESENT CHAIN (shared between mods, plain C)
+ * =============================================================
+ * Several mods in one process each inline-hooking eglSwapBuffers stack up in
+ * whatever order they happened to load, and each one saves GL state and
+ * copies the back buffer on its own. The chain lets them share one hook
+ * instead: one library hosts it, the others register effects with it.
+ *
+ * Finding the host: walk the loaded libraries in load order
+ * (dl_iterate_phdr), dlopen each with RTLD_NOLOAD, dlsym PRESENT_CHAIN_SYMBOL
+ * and call it. The first one that returns non-null is the host, whichever
+ * library is asking, so every participant agrees without talking to the
+ * others first - even when they were loaded RTLD_LOCAL. A library that finds
+ * itself hosts and hooks the swap; any other just calls add() and leaves
+ * eglSwapBuffers alone.
+ *
+ * Per swap the host saves GL state once (skipped if every effect says it
+ * leaves state alone), runs the effects in ascending order and restores it.
+ * The first effect reads the surface; each later one reads the previous
+ * one's output from a shared RGBA8 texture; the last one writes the surface.
+ * Effects run on the thread with the app's context current.
+ *
+ * Structs start with a size field the caller sets to sizeof(struct); newer
+ * hosts only read what the caller knows about. */
+
+#define PRESENT_CHAIN_VERSION 1
+#define PRESENT_CHAIN_SYMBOL "present_chain_v1"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned size;            /* sizeof(PresentTarget), set by the host */
+    int width, height;        /* surface size; input and output both have it */
+    unsigned input_fbo;       /* read this (0 = the surface) */
+    unsigned input_texture;   /* GL_TEXTURE_2D behind input_fbo, 0 when that is the surface */
+    unsigned output_fbo;      /* write every pixel of this (0 = the surface) */
+    const int* damage;        /* x0,y0,x1,y1 the app redrew; only set when reading and writing the surface */
+    void* display;            /* EGLDisplay */
+    void* surface;            /* EGLSurface */
+} PresentTarget;
+
+enum {
+    PRESENT_READS_SURFACE = 1,   /* may be handed input_fbo == output_fbo == 0; otherwise the host copies the surface out first */
+    PRESENT_KEEPS_STATE   = 2    /* leaves GL state as it found it (or the app is known to set everything each frame) */
+};
+
+typedef struct {
+    unsigned size;            /* sizeof(PresentEffect), set by the caller */
+    const char* name;         /* for logs */
+    int order;                /* lower runs first; ties run in registration order */
+    unsigned flags;           /* PRESENT_* */
+    void (*run)(const PresentTarget* target, void* user);
+    void* user;
+} PresentEffect;
+
+typedef struct {
+    unsigned size, version;
+    /* Copies the effect; returns an id > 0, or 0 if the chain is full */
+    int (*add)(const PresentEffect* effect);
+    void (*remove)(int id);
+    /* The host's swap hook calls this before the real swap; returns how many effects ran */
+    int (*run)(void* display, void* surface, int width, int height, const int* damage);
+} PresentChain;
+
+/* Non-null when this library takes part in a chain */
+typedef PresentChain* (*PresentChainFn)(void);
+
+#ifdef __cplusplus
+}
+
+// This library's side (PresentChain.cpp)
+void presentChainEnable(bool on);   // off: present_chain_v1() answers null and nobody joins us
+PresentChain* presentChainLocal();  // our registry, whether or not anyone else uses it
+PresentChain* presentChainFind();   // the host's registry, or null if no loaded library hosts
+#endif
+
+#endif
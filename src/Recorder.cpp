@@ -0,0 +1,128 @@
+#include "Recorder.h"
+#include <ctime>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+#include "Workers.h"
+
+static const uint32_t QUEUE = 16;   // power of two, more than the render side's buffer ring
+static RecordJob jobs[QUEUE];
+static std::atomic<uint32_t> head{0}, tail{0};
+static const char* outDir=0;
+static std::atomic<bool> ready{false}, draining{false};
+
+static void chunk(FILE* f, const char* type, const uint8_t* d, uint32_t n){
+    uint8_t be[4]={(uint8_t)(n>>24),(uint8_t)(n>>16),(uint8_t)(n>>8),(uint8_t)n};
+    fwrite(be,1,4,f); fwrite(type,1,4,f); if(n) fwrite(d,1,n,f);
+    uLong c=crc32(0,(const Bytef*)type,4);
+    if(n) c=crc32(c,d,n);   // a null buffer would reset the crc
+    uint8_t cb[4]={(uint8_t)(c>>24),(uint8_t)(c>>16),(uint8_t)(c>>8),(uint8_t)c};
+    fwrite(cb,1,4,f);
+}
+
+bool writePng(const char* path, const uint8_t* rgba, int w, int h){
+    std::vector<uint8_t> raw((size_t)(w*3+1)*h);
+    for(int y=0;y<h;y++){
+        uint8_t* o=&raw[(size_t)(w*3+1)*y]; *o++=0;   // filter: none
+        const uint8_t* s=rgba+(size_t)w*4*(h-1-y);
+        for(int x=0;x<w;x++,s+=4){ *o++=s[0]; *o++=s[1]; *o++=s[2]; }
+    }
+    uLongf n=compressBound(raw.size()); std::vector<uint8_t> z(n);
+    if(compress2(z.data(),&n,raw.data(),raw.size(),1)!=Z_OK) return false;   // speed over size
+    FILE* f=fopen(path,"wb"); if(!f) return false;
+    static const uint8_t sig[8]={0x89,'P','N','G','\r','\n',0x1a,'\n'};
+    uint8_t ihdr[13]={(uint8_t)(w>>24),(uint8_t)(w>>16),(uint8_t)(w>>8),(uint8_t)w,(uint8_t)(h>>24),(uint8_t)(h>>16),(uint8_t)(h>>8),(uint8_t)h,8,2,0,0,0};
+    fwrite(sig,1,8,f); chunk(f,"IHDR",ihdr,13); chunk(f,"IDAT",z.data(),n); chunk(f,"IEND",0,0);
+    return fclose(f)==0;
+}
+
+void writeY4mHeader(FILE* f, int w, int h, int fps){ fprintf(f,"YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",w,h,fps); }
+
+// Full-range BT.601, chroma averaged over each 2x2 block
+void writeY4mFrame(FILE* f, const uint8_t* rgba, int w, int h){
+    int cw=(w+1)/2, ch=(h+1)/2;
+    std::vector<uint8_t> yuv((size_t)w*h+2*(size_t)cw*ch);
+    uint8_t *Y=yuv.data(), *U=Y+(size_t)w*h, *V=U+(size_t)cw*ch;
+    auto px=[&](int x,int y){ return rgba+((size_t)(h-1-y)*w+x)*4; };
+    for(int y=0;y<h;y++) for(int x=0;x<w;x++){ const uint8_t* p=px(x,y); Y[(size_t)y*w+x]=(uint8_t)((77*p[0]+150*p[1]+29*p[2]+128)>>8); }
+    for(int y=0;y<ch;y++) for(int x=0;x<cw;x++){
+        int r=0,g=0,b=0,n=0;
+        for(int dy=0;dy<2;dy++) for(int dx=0;dx<2;dx++){
+            int sx=2*x+dx, sy=2*y+dy; if(sx>=w || sy>=h) continue;
+            const uint8_t* p=px(sx,sy); r+=p[0]; g+=p[1]; b+=p[2]; n++;
+        }
+        r/=n; g/=n; b/=n;
+        U[(size_t)y*cw+x]=(uint8_t)((-43*r-85*g+128*b+128*256)>>8);
+        V[(size_t)y*cw+x]=(uint8_t)((128*r-107*g-21*b+128*256)>>8);
+    }
+    fputs("FRAME\n",f); fwrite(yuv.data(),1,yuv.size(),f);
+}
+
+static void run(const RecordJob& j){
+    static FILE* clip=0; static int kind=REC_PNG, cw=0, ch=0;   // one drain at a time touches these
+    char path[256];
+    if(j.type==RecordJob::OPEN){
+        kind=j.kind; cw=j.w; ch=j.h;
+        if(clip){ fclose(clip); clip=0; }
+        if(kind==REC_Y4M){
+            time_t now=time(0); char ts[32]; strftime(ts,sizeof(ts),"%Y%m%d-%H%M%S",localtime(&now));
+            snprintf(path,sizeof(path),"%s/motionblur-%s.y4m",outDir,ts);
+            if((clip=fopen(path,"wb"))) writeY4mHeader(clip,cw,ch,j.fps);
+        }
+    }
+    else if(j.type==RecordJob::FRAME){
+        if(kind==REC_PNG){
+            time_t now=time(0); char ts[32]; strftime(ts,sizeof(ts),"%Y%m%d-%H%M%S",localtime(&now));
+            static int n=0; static time_t last=0; n=now==last?n+1:0; last=now;
+            if(n) snprintf(path,sizeof(path),"%s/motionblur-%s-%d.png",outDir,ts,n);
+            else snprintf(path,sizeof(path),"%s/motionblur-%s.png",outDir,ts);
+            writePng(path,j.px,j.w,j.h);
+        }
+        else if(clip && j.w==cw && j.h==ch) writeY4mFrame(clip,j.px,j.w,j.h);   // a resized frame can't join the clip
+        j.done->store(true,std::memory_order_release);
+    }
+    else if(j.type==RecordJob::COPY){ memcpy(j.dst,j.px,j.bytes); j.done->store(true,std::memory_order_release); }
+    else if(clip){ fclose(clip); clip=0; }
+}
+
+// At most one drain is queued or running, which keeps the jobs in order. It
+// empties the queue, then checks once more for a push that saw it still busy.
+static void drain(void*){
+    for(;;){
+        uint32_t t=tail.load(std::memory_order_relaxed);
+        for(;t!=head.load(std::memory_order_acquire);t++){
+            RecordJob j=jobs[t%QUEUE];
+            tail.store(t+1,std::memory_order_release);
+            run(j);
+        }
+        draining.store(false,std::memory_order_seq_cst);
+        if(t==head.load(std::memory_order_seq_cst) || draining.exchange(true,std::memory_order_seq_cst)) return;
+    }
+}
+
+void recorderInit(const char* dir){
+    if(ready.load(std::memory_order_acquire)) return;
+    outDir=dir; workersStart();
+    ready.store(true,std::memory_order_release);
+}
+
+// Queues the drain if jobs wait and none is queued or running
+static void kick(){
+    if(tail.load(std::memory_order_acquire)==head.load(std::memory_order_seq_cst)) return;
+    if(!draining.exchange(true,std::memory_order_seq_cst) && !workPost(drain,0,WORK_URGENT)) draining.store(false,std::memory_order_relaxed);
+}
+
+void recordKick(){ if(ready.load(std::memory_order_acquire)) kick(); }
+
+bool recordPush(const RecordJob& j){
+    if(!ready.load(std::memory_order_acquire)) return false;
+    uint32_t h=head.load(std::memory_order_relaxed);
+    if(h-tail.load(std::memory_order_acquire)>=QUEUE) return false;
+    jobs[h%QUEUE]=j;
+    head.store(h+1,std::memory_order_seq_cst);
+    // Encoded frames free the render thread's readback buffers, so the drain goes first.
+    // If it can't be queued the job waits for recordKick() or the next push.
+    kick();
+    return true;
+}
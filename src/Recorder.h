@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+// =============================================================
+// RECORDER: encoder side of screenshots and clips
+// =============================================================
+// The render thread hands over frames still sitting in mapped pixel-pack
+// buffers (RGBA, bottom row first, as glReadPixels left them). The jobs run
+// on the worker pool (Workers.h), one at a time and strictly in push order;
+// each frame's `done` flag flips when it is encoded, after which the render
+// thread may unmap the buffer. recordPush() never waits: when the queue is
+// full it returns false and the caller drops the frame. Plain copies (frame
+// dump ring) go through the same queue.
+enum RecordKind { REC_PNG, REC_Y4M };
+
+struct RecordJob {
+    enum { OPEN, FRAME, CLOSE, COPY } type;
+    int kind, w, h, fps;                 // OPEN
+    const uint8_t* px;                   // FRAME: w*h*4 bytes, valid until *done is set (COPY: the source)
+    std::atomic<bool>* done;
+    uint8_t* dst; size_t bytes;          // COPY
+};
+
+// Starts the worker pool (once); recordings go to dir as motionblur-<time>[-n].png / .y4m
+void recorderInit(const char* dir);
+bool recordPush(const RecordJob& j);
+// Queues the drain again if a push couldn't (the pushing thread's worker lane
+// was full). The render thread calls it every frame, so the last jobs of a
+// recording, its CLOSE included, don't wait for a push that never comes.
+void recordKick();
+
+// Encoders, also usable on their own. Rows are read bottom-up; alpha is dropped.
+bool writePng(const char* path, const uint8_t* rgba, int w, int h);
+void writeY4mHeader(FILE* f, int w, int h, int fps);
+void writeY4mFrame(FILE* f, const uint8_t* rgba, int w, int h);
@@ -0,0 +1,141 @@
+#include <cmath>
+#include <cstring>
+
+#include "Redirect.h"
+#include "Pipeline.h"
+
+bool inHook=false, uiPhase=false;
+GLuint drawBound=0, readBound=0;
+static GLint vp[4]={0,0,0,0}, sc[4]={0,0,0,0};
+
+void (*oBindFramebuffer)(GLenum,GLuint)=0;
+void (*oViewport)(GLint,GLint,GLsizei,GLsizei)=0;
+void (*oScissor)(GLint,GLint,GLsizei,GLsizei)=0;
+void (*oBlitFramebuffer)(GLint,GLint,GLint,GLint,GLint,GLint,GLint,GLint,GLbitfield,GLenum)=0;
+void (*oInvalidateFramebuffer)(GLenum,GLsizei,const GLenum*)=0;
+void (*oGetIntegerv)(GLenum,GLint*)=0;
+void (*oGetIntegeri_v)(GLenum,GLuint,GLint*)=0;
+void (*oReadPixels)(GLint,GLint,GLsizei,GLsizei,GLenum,GLenum,void*)=0;
+void (*oCopyTexImage2D)(GLenum,GLint,GLenum,GLint,GLint,GLsizei,GLsizei,GLint)=0;
+void (*oCopyTexSubImage2D)(GLenum,GLint,GLint,GLint,GLint,GLint,GLsizei,GLsizei)=0;
+void (*oCopyTexSubImage3D)(GLenum,GLint,GLint,GLint,GLint,GLint,GLint,GLsizei,GLsizei)=0;
+
+static inline bool redir(){return gameFBO && !uiPhase;}
+static inline GLint sx(GLint x){return (GLint)lroundf(x*(float)gW/sW);}
+static inline GLint sy(GLint y){return (GLint)lroundf(y*(float)gH/sH);}
+
+static void applyRect(){
+    if(redir() && drawBound==0){
+        oViewport(sx(vp[0]),sy(vp[1]),sx(vp[0]+vp[2])-sx(vp[0]),sy(vp[1]+vp[3])-sy(vp[1]));
+        oScissor(sx(sc[0]),sy(sc[1]),sx(sc[0]+sc[2])-sx(sc[0]),sy(sc[1]+sc[3])-sy(sc[1]));
+    } else { oViewport(vp[0],vp[1],vp[2],vp[3]); oScissor(sc[0],sc[1],sc[2],sc[3]); }
+}
+
+void hBindFramebuffer(GLenum t, GLuint f){
+    if(inHook) return oBindFramebuffer(t,f);
+    bool was=drawBound==0;
+    if(t!=GL_READ_FRAMEBUFFER) drawBound=f;
+    if(t!=GL_DRAW_FRAMEBUFFER) readBound=f;
+    oBindFramebuffer(t,(f||!redir())?f:gameFBO);
+    if(redir() && was!=(drawBound==0)) applyRect();   // viewport is context state, rescale on target change
+}
+
+void hViewport(GLint x, GLint y, GLsizei w, GLsizei h){
+    if(inHook) return oViewport(x,y,w,h);
+    vp[0]=x; vp[1]=y; vp[2]=w; vp[3]=h;
+    if(redir() && !drawBound) oViewport(sx(x),sy(y),sx(x+w)-sx(x),sy(y+h)-sy(y)); else oViewport(x,y,w,h);
+}
+
+void hScissor(GLint x, GLint y, GLsizei w, GLsizei h){
+    if(inHook) return oScissor(x,y,w,h);
+    sc[0]=x; sc[1]=y; sc[2]=w; sc[3]=h;
+    if(redir() && !drawBound) oScissor(sx(x),sy(y),sx(x+w)-sx(x),sy(y+h)-sy(y)); else oScissor(x,y,w,h);
+}
+
+void hBlitFramebuffer(GLint x0,GLint y0,GLint x1,GLint y1,GLint X0,GLint Y0,GLint X1,GLint Y1,GLbitfield m,GLenum f){
+    if(!inHook && redir()){
+        if(readBound==0){x0=sx(x0);y0=sy(y0);x1=sx(x1);y1=sy(y1);}
+        if(drawBound==0){X0=sx(X0);Y0=sy(Y0);X1=sx(X1);Y1=sy(Y1);}
+    }
+    oBlitFramebuffer(x0,y0,x1,y1,X0,Y0,X1,Y1,m,f);
+}
+
+void hInvalidateFramebuffer(GLenum t, GLsizei n, const GLenum* a){
+    // Default-framebuffer attachment names are invalid on a user FBO
+    if(inHook || !redir() || (t==GL_READ_FRAMEBUFFER?readBound:drawBound) || n>8) return oInvalidateFramebuffer(t,n,a);
+    GLenum r[8];
+    for(int i=0;i<n;i++) r[i]= a[i]==GL_COLOR?GL_COLOR_ATTACHMENT0 : a[i]==GL_DEPTH?GL_DEPTH_ATTACHMENT : a[i]==GL_STENCIL?GL_STENCIL_ATTACHMENT : a[i];
+    oInvalidateFramebuffer(t,n,r);
+}
+
+// A save/restore caller (ImGui's GL backend) must get back what it set, not the
+// scaled rectangle, and never gameFBO's name: rebinding that would bypass the redirect
+void hGetIntegerv(GLenum p, GLint* v){
+    if(inHook || !redir()) return oGetIntegerv(p,v);
+    if(p==GL_VIEWPORT) memcpy(v,vp,sizeof(vp));
+    else if(p==GL_SCISSOR_BOX) memcpy(v,sc,sizeof(sc));
+    else if(p==GL_DRAW_FRAMEBUFFER_BINDING) *v=(GLint)drawBound;   // also GL_FRAMEBUFFER_BINDING
+    else if(p==GL_READ_FRAMEBUFFER_BINDING) *v=(GLint)readBound;
+    else oGetIntegerv(p,v);
+}
+
+void hGetIntegeri_v(GLenum p, GLuint i, GLint* v){
+    if(inHook || !redir() || i || (p!=GL_VIEWPORT && p!=GL_SCISSOR_BOX)) return oGetIntegeri_v(p,i,v);
+    memcpy(v,p==GL_VIEWPORT?vp:sc,sizeof(vp));
+}
+
+// Reads from the game's framebuffer 0: the rectangle is upscaled from gameFBO into
+// a scratch target (grown as needed, never shrunk) at the size the game asked for,
+// which is left bound for reading at (0,0). False: read as asked, nothing changed.
+static GLuint readFBO=0, readRB=0;
+static int readW=0, readH=0;
+
+static bool readBegin(GLint x, GLint y, GLsizei w, GLsizei h){
+    if(inHook || !redir() || readBound || w<=0 || h<=0) return false;
+    inHook=true;   // our own binds and enables below go straight through
+    if(w>readW || h>readH){
+        GLint rb=0; oGetIntegerv(GL_RENDERBUFFER_BINDING,&rb);
+        if(!readFBO){ glGenFramebuffers(1,&readFBO); glGenRenderbuffers(1,&readRB); }
+        readW=w>readW?w:readW; readH=h>readH?h:readH;
+        glBindRenderbuffer(GL_RENDERBUFFER,readRB); glRenderbufferStorage(GL_RENDERBUFFER,GL_RGBA8,readW,readH);
+        oBindFramebuffer(GL_DRAW_FRAMEBUFFER,readFBO); glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_RENDERBUFFER,readRB);
+        glBindRenderbuffer(GL_RENDERBUFFER,(GLuint)rb);
+    }
+    bool scissor=glIsEnabled(GL_SCISSOR_TEST);   // blits are scissored
+    if(scissor) glDisable(GL_SCISSOR_TEST);
+    oBindFramebuffer(GL_DRAW_FRAMEBUFFER,readFBO);
+    oBlitFramebuffer(sx(x),sy(y),sx(x+w),sy(y+h),0,0,w,h,GL_COLOR_BUFFER_BIT,GL_LINEAR);
+    oBindFramebuffer(GL_DRAW_FRAMEBUFFER,drawBound?drawBound:gameFBO);
+    oBindFramebuffer(GL_READ_FRAMEBUFFER,readFBO);
+    if(scissor) glEnable(GL_SCISSOR_TEST);
+    inHook=false;
+    return true;
+}
+static void readEnd(){ oBindFramebuffer(GL_READ_FRAMEBUFFER,gameFBO); }
+
+void hReadPixels(GLint x, GLint y, GLsizei w, GLsizei h, GLenum f, GLenum t, void* p){
+    if(!readBegin(x,y,w,h)) return oReadPixels(x,y,w,h,f,t,p);
+    oReadPixels(0,0,w,h,f,t,p); readEnd();
+}
+
+void hCopyTexImage2D(GLenum t, GLint l, GLenum fmt, GLint x, GLint y, GLsizei w, GLsizei h, GLint b){
+    if(!readBegin(x,y,w,h)) return oCopyTexImage2D(t,l,fmt,x,y,w,h,b);
+    oCopyTexImage2D(t,l,fmt,0,0,w,h,b); readEnd();
+}
+
+void hCopyTexSubImage2D(GLenum t, GLint l, GLint ox, GLint oy, GLint x, GLint y, GLsizei w, GLsizei h){
+    if(!readBegin(x,y,w,h)) return oCopyTexSubImage2D(t,l,ox,oy,x,y,w,h);
+    oCopyTexSubImage2D(t,l,ox,oy,0,0,w,h); readEnd();
+}
+
+void hCopyTexSubImage3D(GLenum t, GLint l, GLint ox, GLint oy, GLint oz, GLint x, GLint y, GLsizei w, GLsizei h){
+    if(!readBegin(x,y,w,h)) return oCopyTexSubImage3D(t,l,ox,oy,oz,x,y,w,h);
+    oCopyTexSubImage3D(t,l,ox,oy,oz,0,0,w,h); readEnd();
+}
+
+void redirectRebind(){
+    GLuint def=redir()?gameFBO:0;
+    oBindFramebuffer(GL_DRAW_FRAMEBUFFER,drawBound?drawBound:def);
+    oBindFramebuffer(GL_READ_FRAMEBUFFER,readBound?readBound:def);
+    applyRect();
+}
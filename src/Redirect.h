@@ -0,0 +1,43 @@
+#pragma once
+#include <GLES3/gl3.h>
+
+// =============================================================
+// GAME RESOLUTION REDIRECT
+// =============================================================
+// While gameFBO exists, every bind of framebuffer 0 by the game lands in gameFBO
+// and its viewport/scissor/blit rectangles are scaled to gW x gH. The game keeps
+// seeing surface-sized coordinates, in what it sets and in what it reads back:
+// glGetIntegerv answers with its own viewport, scissor and bindings, and reads
+// from framebuffer 0 (glReadPixels, glCopyTex*Image) are upscaled from gameFBO.
+// Only render() touches the real surface. The h* functions replace the GL entry
+// points of the same name (main.cpp patches them in); o* are the originals.
+extern bool inHook;                 // our own GL calls bypass the redirect
+extern bool uiPhase;                // HUD goes straight to the real surface (scene capture)
+extern GLuint drawBound, readBound; // bindings as the game believes them
+
+extern void (*oBindFramebuffer)(GLenum,GLuint);
+extern void (*oViewport)(GLint,GLint,GLsizei,GLsizei);
+extern void (*oScissor)(GLint,GLint,GLsizei,GLsizei);
+extern void (*oBlitFramebuffer)(GLint,GLint,GLint,GLint,GLint,GLint,GLint,GLint,GLbitfield,GLenum);
+extern void (*oInvalidateFramebuffer)(GLenum,GLsizei,const GLenum*);
+extern void (*oGetIntegerv)(GLenum,GLint*);
+extern void (*oGetIntegeri_v)(GLenum,GLuint,GLint*);
+extern void (*oReadPixels)(GLint,GLint,GLsizei,GLsizei,GLenum,GLenum,void*);
+extern void (*oCopyTexImage2D)(GLenum,GLint,GLenum,GLint,GLint,GLsizei,GLsizei,GLint);
+extern void (*oCopyTexSubImage2D)(GLenum,GLint,GLint,GLint,GLint,GLint,GLsizei,GLsizei);
+extern void (*oCopyTexSubImage3D)(GLenum,GLint,GLint,GLint,GLint,GLint,GLint,GLsizei,GLsizei);
+
+void hBindFramebuffer(GLenum t, GLuint f);
+void hViewport(GLint x, GLint y, GLsizei w, GLsizei h);
+void hScissor(GLint x, GLint y, GLsizei w, GLsizei h);
+void hBlitFramebuffer(GLint x0,GLint y0,GLint x1,GLint y1,GLint X0,GLint Y0,GLint X1,GLint Y1,GLbitfield m,GLenum f);
+void hInvalidateFramebuffer(GLenum t, GLsizei n, const GLenum* a);
+void hGetIntegerv(GLenum p, GLint* v);
+void hGetIntegeri_v(GLenum p, GLuint i, GLint* v);
+void hReadPixels(GLint x, GLint y, GLsizei w, GLsizei h, GLenum f, GLenum t, void* p);
+void hCopyTexImage2D(GLenum t, GLint l, GLenum fmt, GLint x, GLint y, GLsizei w, GLsizei h, GLint b);
+void hCopyTexSubImage2D(GLenum t, GLint l, GLint ox, GLint oy, GLint x, GLint y, GLsizei w, GLsizei h);
+void hCopyTexSubImage3D(GLenum t, GLint l, GLint ox, GLint oy, GLint oz, GLint x, GLint y, GLsizei w, GLsizei h);
+
+// Puts the game's bindings, viewport and scissor back after our own GL work
+void redirectRebind();
@@ -0,0 +1,32 @@
+#pragma once
+#include <atomic>
+#include <cstring>
+
+// Single-writer seqlock. The writer never waits; readers retry if they raced a
+// store. T must be trivially copyable. version() lets a reader skip the copy
+// entirely when nothing changed since it last looked.
+template<class T> struct Seqlock {
+    std::atomic<unsigned> seq{0};
+    T val{};
+
+    void store(const T& v){
+        unsigned s=seq.load(std::memory_order_relaxed);
+        seq.store(s+1,std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy((void*)&val,&v,sizeof(T));
+        seq.store(s+2,std::memory_order_release);
+    }
+
+    T load() const {
+        T v; unsigned a,b;
+        do{
+            a=seq.load(std::memory_order_acquire);
+            memcpy((void*)&v,(const void*)&val,sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            b=seq.load(std::memory_order_relaxed);
+        }while(a!=b || (a&1));
+        return v;
+    }
+
+    unsigned version() const { return seq.load(std::memory_order_acquire); }
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include "Seqlock.h"
+
+// Live counters published in a memory-mapped file for overlays and loggers
+// outside the game process. Readers map it read-only and use stats.load(),
+// which retries on a torn read instead of ever blocking the render thread.
+// Bump STATS_VERSION whenever Stats changes layout.
+static const uint32_t STATS_VERSION = 2;
+
+enum StatsFlags { STATS_REDIRECT=1, STATS_CHECKERBOARD=2, STATS_UI_MASK=4, STATS_TRACING=8 };
+
+struct Stats {
+    uint64_t frames, skipped;     // presents seen / of those, passed through untouched
+    uint64_t updated;             // CLOCK_MONOTONIC ns of the last publish
+    uint64_t textureBytes;        // everything initGL() allocated
+    float fps;                    // swap rate, smoothed over ~16 frames
+    float passMs[3];              // last GPU time of capture, blur, draw (0 without timer queries)
+    float scale, gameScale;       // internal blur scale, game render scale
+    int32_t width, height;        // output size
+    int32_t levels, ring, turns;  // fovea levels, capture ring, quarter turns of pre-rotation
+    uint32_t flags;               // StatsFlags
+    char capture[20];             // "blit" | "resolve" | "resolve+downscale"
+    int32_t governor;             // quality governor level (0 = full quality)
+    float temp;                   // what the governor last read: hottest zone in C (< 0 unknown)
+    int32_t battery;              // battery % (< 0 unknown)
+};
+
+struct StatsFile {
+    char magic[4];                // "MBST"
+    uint32_t version, size;       // STATS_VERSION, sizeof(StatsFile)
+    Seqlock<Stats> stats;
+};
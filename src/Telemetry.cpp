@@ -0,0 +1,126 @@
+#include "Telemetry.h"
+#include "Log.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+
+TraceRing traceRing;
+LogRing logRing;
+std::atomic<bool> tracing{false};
+static std::atomic<const char*> tracePath{0};
+static const char* const* names=0;
+static pthread_t writer;
+static bool writerUp=false;
+
+// Chrome JSON array format: the closing ']' is optional, so a trace cut short
+// by the game being killed still loads. pid 1 = this mod; tid 1 = the hook on
+// the render thread, tid 2 = our GPU passes. The game's own frame time is the
+// gap between hook spans and the swap_interval counter.
+static void json(FILE* f, const TraceRecord& r, uint64_t& lastSwap){
+    double us=r.t/1000.0;
+    const char* pn=names && r.a<8 ? names[r.a] : "?";
+    switch(r.type){
+    case EV_HOOK_BEGIN:
+        if(lastSwap) fprintf(f,"{\"name\":\"swap_interval\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"ms\":%.3f}},\n",us,(r.t-lastSwap)*1e-6);
+        lastSwap=r.t;
+        fprintf(f,"{\"name\":\"hook\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,\"tid\":1},\n",us); break;
+    case EV_HOOK_END:   fprintf(f,"{\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":1},\n",us); break;
+    case EV_PASS_BEGIN: fprintf(f,"{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,\"tid\":1},\n",pn,us); break;
+    case EV_PASS_END:   fprintf(f,"{\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":1},\n",us); break;
+    case EV_GPU_PASS:   fprintf(f,"{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":2},\n",pn,us,r.b/1000.0); break;
+    default: {
+        static const char* inst[]={0,0,0,0,"skip","resize","compile","config","dropped",0,"clock_sync"};
+        if(r.type<sizeof(inst)/sizeof(*inst) && inst[r.type])
+            fprintf(f,"{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%.3f,\"pid\":1,\"tid\":1,\"args\":{\"a\":%u,\"b\":%u}},\n",inst[r.type],us,r.a,r.b);
+    }}
+}
+
+// One logLater() line: each conversion is re-issued to snprintf on its own with the
+// argument's widened type (length modifiers are replaced, '*' widths unsupported)
+static void format(char* out, size_t cap, const LogRecord& r){
+    size_t n=0; uint32_t k=0;
+    for(const char* p=r.fmt; *p && n+1<cap;){
+        if(*p!='%'){ out[n++]=*p++; continue; }
+        if(p[1]=='%'){ out[n++]='%'; p+=2; continue; }
+        char spec[32]; int m=0; spec[m++]=*p++;
+        while(*p && strchr("-+ #0123456789.",*p) && m<24) spec[m++]=*p++;
+        while(*p && strchr("hlLqjzt",*p)) p++;
+        char c=*p?*p++:'s';
+        LogArg a=k<r.n?r.a[k]:LogArg{0}; bool have=k++<r.n;
+        int w;
+        if(!have) w=snprintf(out+n,cap-n,"?");
+        else if(c=='s'){ spec[m++]='s'; spec[m]=0; w=snprintf(out+n,cap-n,spec,a.s?a.s:"(null)"); }
+        else if(strchr("fFeEgGaA",c)){ spec[m++]=c; spec[m]=0; w=snprintf(out+n,cap-n,spec,a.d); }
+        else if(c=='c'){ spec[m++]='c'; spec[m]=0; w=snprintf(out+n,cap-n,spec,(int)a.i); }
+        else { spec[m++]='l'; spec[m++]='l'; spec[m++]=c; spec[m]=0; w=snprintf(out+n,cap-n,spec,a.i); }
+        if(w>0) n+=(size_t)w<cap-n?(size_t)w:cap-n-1;
+    }
+    out[n]=0;
+}
+
+// Consumers: the writer thread, and logFlush() on the tools' main thread
+static pthread_mutex_t logDrain=PTHREAD_MUTEX_INITIALIZER;
+
+static void drainLogs(){
+    pthread_mutex_lock(&logDrain);
+    uint32_t t=logRing.tail.load(std::memory_order_relaxed), h=logRing.head.load(std::memory_order_acquire);
+    for(;t!=h;t++){
+        char line[512]; format(line,sizeof(line),logRing.r[t&(LogRing::N-1)]);
+        logRing.tail.store(t+1,std::memory_order_release);
+        LOG("%s",line);
+    }
+    if(uint32_t d=logRing.dropped.exchange(0,std::memory_order_relaxed)) LOG("%u log lines dropped",d);
+    pthread_mutex_unlock(&logDrain);
+}
+
+void logFlush(){ drainLogs(); }
+
+static FILE* openTrace(const char* path, bool& asJson){
+    if(!path) return 0;   // writer started for the logs only
+    FILE* f=fopen(path,"wb"); if(!f) return 0;
+    size_t n=strlen(path); asJson=n>5 && !strcmp(path+n-5,".json");
+    if(asJson) fputs("[\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"hook (CPU)\"}},\n"
+                     "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"passes (GPU)\"}},\n",f);
+    else { TraceHeader hd={{'M','B','T','R'},TRACE_VERSION,sizeof(TraceRecord),CLOCK_MONOTONIC}; fwrite(&hd,sizeof(hd),1,f); }
+    return f;
+}
+
+static void* writerThread(void*){
+    FILE* f=0; const char* cur=0; bool asJson=false; uint64_t lastSwap=0;
+    TraceRecord buf[1025];   // one spare for the drop report
+    for(;;){
+        const char* want=tracePath.load(std::memory_order_acquire);
+        if(want!=cur){ if(f) fclose(f); f=openTrace(want,asJson); cur=want; lastSwap=0; }
+        uint32_t t=traceRing.tail.load(std::memory_order_relaxed), h=traceRing.head.load(std::memory_order_acquire);
+        uint32_t n=0;
+        while(t!=h && n<1024) buf[n++]=traceRing.r[(t++)&(TraceRing::N-1)];
+        traceRing.tail.store(t,std::memory_order_release);
+        if(uint32_t d=traceRing.dropped.exchange(0,std::memory_order_relaxed)) buf[n++]={traceNow(),EV_DROPPED,0,d};
+        if(n && f){
+            if(asJson) for(uint32_t i=0;i<n;i++) json(f,buf[i],lastSwap);
+            else fwrite(buf,sizeof(TraceRecord),n,f);
+            if(n<1024) fflush(f);
+        }
+        drainLogs();
+        if(n<1024) usleep(10000);
+    }
+    return 0;
+}
+
+static pthread_mutex_t writerStart=PTHREAD_MUTEX_INITIALIZER;
+
+void traceWriterStart(){
+    pthread_mutex_lock(&writerStart);
+    if(!writerUp && pthread_create(&writer,0,writerThread,0)==0){ pthread_detach(writer); writerUp=true; }
+    pthread_mutex_unlock(&writerStart);
+}
+
+void traceStart(const char* path, const char* const* passNames){
+    names=passNames;
+    tracePath.store(path,std::memory_order_release);
+    traceWriterStart();
+    tracing.store(true,std::memory_order_relaxed);
+}
+
+void traceStop(){ tracing.store(false,std::memory_order_relaxed); }
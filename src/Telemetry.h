@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <time.h>
+
+// =============================================================
+// TELEMETRY: render thread -> lock-free SPSC ring -> trace writer thread
+// =============================================================
+// trace() is the only call allowed inside hook(): one clock read and one 16-byte
+// store, no locks, no allocation, no I/O. A full ring drops the event and counts
+// it; the writer reports the count as an EV_DROPPED record.
+enum TraceEvent : uint16_t {
+    EV_HOOK_BEGIN, EV_HOOK_END,     // a = 0
+    EV_PASS_BEGIN, EV_PASS_END,     // a = pass
+    EV_SKIP,                        // frame not processed (b = surface width)
+    EV_RESIZE,                      // a/b = new width/height
+    EV_COMPILE,                     // shader programs rebuilt
+    EV_CONFIG,                      // new config snapshot picked up
+    EV_DROPPED,                     // b = events lost to a full ring
+    EV_GPU_PASS,                    // a = pass, b = duration ns, t = GPU start on the CPU clock
+    EV_CLOCK_SYNC,                  // GPU clock re-aligned to CLOCK_MONOTONIC
+};
+
+struct TraceRecord { uint64_t t; uint16_t type, a; uint32_t b; };   // t = CLOCK_MONOTONIC ns
+
+// File layout: TraceHeader, then TraceRecords until EOF
+struct TraceHeader { char magic[4]; uint32_t version, recordSize, clock; };
+static const uint32_t TRACE_VERSION = 1;
+
+struct TraceRing {
+    static const uint32_t N = 1u<<14;   // power of two
+    TraceRecord r[N];
+    alignas(64) std::atomic<uint32_t> head{0};   // written by the render thread only
+    alignas(64) std::atomic<uint32_t> tail{0};   // written by the writer thread only
+    alignas(64) std::atomic<uint32_t> dropped{0};
+};
+
+extern TraceRing traceRing;
+extern std::atomic<bool> tracing;
+
+inline uint64_t traceNow(){ timespec ts; clock_gettime(CLOCK_MONOTONIC,&ts); return (uint64_t)ts.tv_sec*1000000000ull+ts.tv_nsec; }
+
+inline void traceAt(uint64_t t, TraceEvent e, uint16_t a=0, uint32_t b=0){
+    uint32_t h=traceRing.head.load(std::memory_order_relaxed);
+    if(h-traceRing.tail.load(std::memory_order_acquire)>=TraceRing::N){ traceRing.dropped.fetch_add(1,std::memory_order_relaxed); return; }
+    traceRing.r[h&(TraceRing::N-1)]={t,(uint16_t)e,a,b};
+    traceRing.head.store(h+1,std::memory_order_release);
+}
+inline void trace(TraceEvent e, uint16_t a=0, uint32_t b=0){ if(tracing.load(std::memory_order_relaxed)) traceAt(traceNow(),e,a,b); }
+
+// Log lines from the render thread go the same way: logLater() stores the format
+// and its arguments as they are (integers widened, floats as double, strings as
+// pointers that must outlive the line: literals and static tables), and the writer
+// thread formats them and hands them to LOG. Render thread only, like trace().
+union LogArg { long long i; double d; const char* s; };
+struct LogRecord { const char* fmt; uint32_t n; LogArg a[16]; };
+
+struct LogRing {
+    static const uint32_t N = 256;   // power of two
+    LogRecord r[N];
+    alignas(64) std::atomic<uint32_t> head{0};
+    alignas(64) std::atomic<uint32_t> tail{0};
+    alignas(64) std::atomic<uint32_t> dropped{0};
+};
+
+extern LogRing logRing;
+
+inline LogArg logArg(double v){ LogArg a; a.d=v; return a; }
+inline LogArg logArg(float v){ return logArg((double)v); }
+inline LogArg logArg(const char* v){ LogArg a; a.s=v; return a; }
+template<class T> inline LogArg logArg(T v){
+    static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "logLater: numbers and static strings only");
+    LogArg a; a.i=(long long)v; return a;
+}
+
+template<class... A> inline void logLater(const char* fmt, A... a){
+    static_assert(sizeof...(A)<=16, "logLater: at most 16 arguments");
+    uint32_t h=logRing.head.load(std::memory_order_relaxed);
+    if(h-logRing.tail.load(std::memory_order_acquire)>=LogRing::N){ logRing.dropped.fetch_add(1,std::memory_order_relaxed); return; }
+    LogRecord& r=logRing.r[h&(LogRing::N-1)];
+    r.fmt=fmt; r.n=sizeof...(A); uint32_t i=0; ((r.a[i++]=logArg(a)),...);
+    logRing.head.store(h+1,std::memory_order_release);
+}
+
+// The writer thread without a trace file: the platform layer starts it before the
+// first frame so logLater() lines come out. logFlush() formats whatever is queued
+// on the calling thread (tools, before they exit).
+void traceWriterStart();
+void logFlush();
+
+// Starts the writer thread on first call; later calls toggle recording and switch
+// files. A path ending in ".json" gets the Chrome JSON array format (opens in
+// Perfetto / chrome://tracing), anything else the binary records above.
+// passNames label EV_PASS_* / EV_GPU_PASS in JSON; it must outlive the writer.
+void traceStart(const char* path, const char* const* passNames);
+void traceStop();
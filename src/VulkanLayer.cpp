@@ -0,0 +1,780 @@
+// Vulkan backend: the VK_LAYER_MOTIONBLUR layer (manifest VkLayer_motionblur.json)
+// Intercepts vkQueuePresentKHR and runs the pipeline on the swapchain image
+// before it is presented: a downscaling blit into the internal resolution, the
+// blur as a compute dispatch ping-ponging two history images, and the output
+// pass (upscale, CAS, vibrance, tonemap) as a single-subpass render pass that
+// writes the swapchain image directly. Nothing full-size is allocated: the
+// swapchain image is both the capture source and the output attachment.
+// Shaders are src/shaders/*, compiled to SPIR-V by glslc at build time.
+// Built into the Android mod with VULKAN_IN_PROCESS, the same functions are
+// patched over libvulkan's exports instead (IN-PROCESS HOOKS, VulkanLayer.h).
+#include <vulkan/vulkan.h>
+#ifndef VULKAN_IN_PROCESS
+#include <vulkan/vk_layer.h>
+#endif
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Log.h"
+#include "Config.h"
+#include "VulkanLayer.h"
+
+#define EXPORT extern "C" __attribute__((visibility("default")))
+
+// =============================================================
+// 1. SETTINGS
+// =============================================================
+static const char* LAYER_NAME = "VK_LAYER_MOTIONBLUR";
+static const char* CONFIG_ENV = "MOTIONBLUR_CONFIG";   // same keys as on Android, re-read when it changes
+static const uint32_t MIN_SIZE = 100;                  // smaller swapchains pass through
+
+static const uint32_t BLUR_SPV[] = {
+#include "blur.comp.inc"
+};
+static const uint32_t VERT_SPV[] = {
+#include "output.vert.inc"
+};
+static const uint32_t FRAG_SPV[] = {
+#include "output.frag.inc"
+};
+
+struct BlurPush { float inner, outer, aspect; int shape, first, srgb; };
+struct DrawPush { float sharpen; int srgb; };
+
+// =============================================================
+// 2. DISPATCH
+// =============================================================
+// Dispatchable handles start with the loader's dispatch table pointer, which
+// is shared by an instance and its physical devices and by a device and its queues.
+template<class T> static void* key(T h){ return *(void**)h; }
+
+#define INSTANCE_FUNCS(X) X(DestroyInstance) X(CreateDevice) X(EnumerateDeviceExtensionProperties) \
+    X(GetPhysicalDeviceMemoryProperties) X(GetPhysicalDeviceQueueFamilyProperties) X(GetPhysicalDeviceFormatProperties) \
+    X(GetPhysicalDeviceSurfaceCapabilitiesKHR)
+
+#define DEVICE_FUNCS(X) X(DestroyDevice) X(GetDeviceQueue) X(DeviceWaitIdle) X(QueueSubmit) X(QueuePresentKHR) \
+    X(CreateSwapchainKHR) X(DestroySwapchainKHR) X(GetSwapchainImagesKHR) \
+    X(CreateImage) X(DestroyImage) X(GetImageMemoryRequirements) X(AllocateMemory) X(FreeMemory) X(BindImageMemory) \
+    X(CreateImageView) X(DestroyImageView) X(CreateSampler) X(DestroySampler) \
+    X(CreateShaderModule) X(DestroyShaderModule) X(CreateDescriptorSetLayout) X(DestroyDescriptorSetLayout) \
+    X(CreatePipelineLayout) X(DestroyPipelineLayout) X(CreateComputePipelines) X(CreateGraphicsPipelines) X(DestroyPipeline) \
+    X(CreateDescriptorPool) X(DestroyDescriptorPool) X(AllocateDescriptorSets) X(UpdateDescriptorSets) \
+    X(CreateRenderPass) X(DestroyRenderPass) X(CreateFramebuffer) X(DestroyFramebuffer) \
+    X(CreateCommandPool) X(DestroyCommandPool) X(AllocateCommandBuffers) X(ResetCommandBuffer) \
+    X(BeginCommandBuffer) X(EndCommandBuffer) X(CmdPipelineBarrier) X(CmdBlitImage) X(CmdBindPipeline) \
+    X(CmdBindDescriptorSets) X(CmdPushConstants) X(CmdDispatch) X(CmdBeginRenderPass) X(CmdEndRenderPass) \
+    X(CmdDraw) X(CmdSetViewport) X(CmdSetScissor) \
+    X(CreateFence) X(DestroyFence) X(WaitForFences) X(ResetFences) X(CreateSemaphore) X(DestroySemaphore)
+
+struct Instance {
+    VkInstance h;
+    PFN_vkGetInstanceProcAddr gipa;
+#define X(n) PFN_vk##n n;
+    INSTANCE_FUNCS(X)
+#undef X
+};
+
+struct Device {
+    VkDevice h;
+    VkPhysicalDevice gpu;
+    Instance* inst;
+    PFN_vkGetDeviceProcAddr gdpa;
+    VkResult (VKAPI_PTR *setData)(VkDevice,void*);   // our command buffers need the loader's dispatch pointer
+#define X(n) PFN_vk##n n;
+    DEVICE_FUNCS(X)
+#undef X
+    VkPhysicalDeviceMemoryProperties mem;
+    std::unordered_map<VkQueue,uint32_t> family;   // queues that can run our passes (graphics + compute)
+    // Shared by all swapchains, created with the first one (under init, not the global lock)
+    std::mutex init;
+    VkSampler smp=0;
+    VkDescriptorSetLayout blurDsl=0, drawDsl=0;
+    VkPipelineLayout blurLayout=0, drawLayout=0;
+    VkPipeline blurPipe=0;
+    VkShaderModule vs=0, fs=0;
+};
+
+struct Swapchain {
+    Device* d;
+    VkFormat fmt;
+    bool srgb;   // the shaders convert, see isSrgb
+    VkExtent2D ext;
+    std::vector<VkImage> images;
+    // Per swapchain image: output target, recording and completion
+    std::vector<VkImageView> views;
+    std::vector<VkFramebuffer> fbs;
+    std::vector<VkCommandBuffer> cmd;
+    std::vector<VkFence> fence;
+    std::vector<VkSemaphore> done;
+    VkRenderPass pass=0;
+    VkPipeline drawPipe=0;
+    VkCommandPool pool=0;
+    uint32_t poolFamily=~0u;
+    // Internal resolution: 0 = capture, 1/2 = history ping-pong
+    float scale=0;
+    float failed=0;   // a scale that couldn't be allocated: frames pass through until the config asks for another
+    uint32_t w=0, h=0;
+    VkImage img[3]={};
+    VkDeviceMemory imgMem[3]={};
+    VkImageView imgView[3]={};
+    VkDescriptorPool sets=0;
+    VkDescriptorSet blurSet[2], drawSet[2];
+    unsigned frame=0;
+    bool fresh=true;   // history holds nothing yet
+};
+
+static std::mutex lock;
+static std::unordered_map<void*,Instance*> instances;
+static std::unordered_map<void*,Device*> devices;
+static std::unordered_map<VkSwapchainKHR,Swapchain*> swapchains;
+
+// =============================================================
+// 3. RESOURCES
+// =============================================================
+static uint32_t memType(Device& d, uint32_t bits, VkMemoryPropertyFlags want){
+    for(uint32_t i=0;i<d.mem.memoryTypeCount;i++)
+        if((bits&(1u<<i)) && (d.mem.memoryTypes[i].propertyFlags&want)==want) return i;
+    return ~0u;
+}
+
+static VkImageView makeView(Device& d, VkImage img, VkFormat fmt){
+    VkImageViewCreateInfo ci={VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    ci.image=img; ci.viewType=VK_IMAGE_VIEW_TYPE_2D; ci.format=fmt;
+    ci.subresourceRange={VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1};
+    VkImageView v=0; d.CreateImageView(d.h,&ci,0,&v);
+    return v;
+}
+
+// The capture blit decodes an sRGB image and the output attachment encodes
+// again. The passes are tuned on encoded values, so the blur encodes what it
+// reads and the output pass decodes what it writes; the capture is half float
+// so the decoded shadows keep their steps.
+static bool isSrgb(VkFormat f){ return f==VK_FORMAT_B8G8R8A8_SRGB || f==VK_FORMAT_R8G8B8A8_SRGB || f==VK_FORMAT_A8B8G8R8_SRGB_PACK32; }
+
+static VkShaderModule makeShader(Device& d, const uint32_t* code, size_t bytes){
+    VkShaderModuleCreateInfo ci={VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    ci.codeSize=bytes; ci.pCode=code;
+    VkShaderModule m=0; d.CreateShaderModule(d.h,&ci,0,&m);
+    return m;
+}
+
+// Sampler, layouts and the compute pipeline: independent of any swapchain
+static bool deviceInit(Device& d){
+    if(d.blurPipe) return true;
+    VkSamplerCreateInfo sc={VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    sc.magFilter=sc.minFilter=VK_FILTER_LINEAR;
+    sc.addressModeU=sc.addressModeV=sc.addressModeW=VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    d.CreateSampler(d.h,&sc,0,&d.smp);
+
+    VkDescriptorSetLayoutBinding bb[3];
+    for(uint32_t i=0;i<3;i++) bb[i]={i,VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,1,VK_SHADER_STAGE_COMPUTE_BIT,0};
+    VkDescriptorSetLayoutBinding db={0,VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,1,VK_SHADER_STAGE_FRAGMENT_BIT,&d.smp};
+    VkDescriptorSetLayoutCreateInfo lc={VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    lc.bindingCount=3; lc.pBindings=bb; d.CreateDescriptorSetLayout(d.h,&lc,0,&d.blurDsl);
+    lc.bindingCount=1; lc.pBindings=&db; d.CreateDescriptorSetLayout(d.h,&lc,0,&d.drawDsl);
+
+    VkPushConstantRange bp={VK_SHADER_STAGE_COMPUTE_BIT,0,sizeof(BlurPush)}, dp={VK_SHADER_STAGE_FRAGMENT_BIT,0,sizeof(DrawPush)};
+    VkPipelineLayoutCreateInfo pc={VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    pc.setLayoutCount=1; pc.pushConstantRangeCount=1;
+    pc.pSetLayouts=&d.blurDsl; pc.pPushConstantRanges=&bp; d.CreatePipelineLayout(d.h,&pc,0,&d.blurLayout);
+    pc.pSetLayouts=&d.drawDsl; pc.pPushConstantRanges=&dp; d.CreatePipelineLayout(d.h,&pc,0,&d.drawLayout);
+
+    d.vs=makeShader(d,VERT_SPV,sizeof(VERT_SPV));
+    d.fs=makeShader(d,FRAG_SPV,sizeof(FRAG_SPV));
+    VkShaderModule cs=makeShader(d,BLUR_SPV,sizeof(BLUR_SPV));
+    VkComputePipelineCreateInfo ci={VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    ci.stage={VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,0,0,VK_SHADER_STAGE_COMPUTE_BIT,cs,"main",0};
+    ci.layout=d.blurLayout;
+    if(d.CreateComputePipelines(d.h,VK_NULL_HANDLE,1,&ci,0,&d.blurPipe)!=VK_SUCCESS) d.blurPipe=0;
+    d.DestroyShaderModule(d.h,cs,0);
+    if(!d.blurPipe) LOG("vulkan: compute pipeline failed, passing through");
+    return d.blurPipe!=0;
+}
+
+static void deviceFree(Device& d){
+    d.DestroyPipeline(d.h,d.blurPipe,0);
+    d.DestroyShaderModule(d.h,d.vs,0); d.DestroyShaderModule(d.h,d.fs,0);
+    d.DestroyPipelineLayout(d.h,d.blurLayout,0); d.DestroyPipelineLayout(d.h,d.drawLayout,0);
+    d.DestroyDescriptorSetLayout(d.h,d.blurDsl,0); d.DestroyDescriptorSetLayout(d.h,d.drawDsl,0);
+    d.DestroySampler(d.h,d.smp,0);
+}
+
+// Capture and history images at scale x the swapchain, plus their descriptor sets
+static bool buildInternal(Swapchain& s, float scale){
+    Device& d=*s.d;
+    s.scale=scale;
+    s.w=std::max(1u,(uint32_t)lroundf(s.ext.width*scale)); s.h=std::max(1u,(uint32_t)lroundf(s.ext.height*scale));
+    for(int i=0;i<3;i++){
+        VkFormat fmt=i==0?VK_FORMAT_R16G16B16A16_SFLOAT:VK_FORMAT_R8G8B8A8_UNORM;   // both mandatory as storage and blit targets
+        VkImageCreateInfo ci={VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+        ci.imageType=VK_IMAGE_TYPE_2D; ci.format=fmt; ci.extent={s.w,s.h,1};
+        ci.mipLevels=ci.arrayLayers=1; ci.samples=VK_SAMPLE_COUNT_1_BIT; ci.tiling=VK_IMAGE_TILING_OPTIMAL;
+        ci.usage=VK_IMAGE_USAGE_STORAGE_BIT|(i==0?VK_IMAGE_USAGE_TRANSFER_DST_BIT:VK_IMAGE_USAGE_SAMPLED_BIT);
+        if(d.CreateImage(d.h,&ci,0,&s.img[i])!=VK_SUCCESS) return false;
+        VkMemoryRequirements req; d.GetImageMemoryRequirements(d.h,s.img[i],&req);
+        VkMemoryAllocateInfo ai={VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        ai.allocationSize=req.size; ai.memoryTypeIndex=memType(d,req.memoryTypeBits,VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if(ai.memoryTypeIndex==~0u || d.AllocateMemory(d.h,&ai,0,&s.imgMem[i])!=VK_SUCCESS) return false;
+        d.BindImageMemory(d.h,s.img[i],s.imgMem[i],0);
+        s.imgView[i]=makeView(d,s.img[i],fmt);
+    }
+
+    VkDescriptorPoolSize ps[]={{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,6},{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,2}};
+    VkDescriptorPoolCreateInfo pc={VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pc.maxSets=4; pc.poolSizeCount=2; pc.pPoolSizes=ps;
+    if(d.CreateDescriptorPool(d.h,&pc,0,&s.sets)!=VK_SUCCESS) return false;
+    VkDescriptorSetLayout dsl[4]={d.blurDsl,d.blurDsl,d.drawDsl,d.drawDsl};
+    VkDescriptorSet set[4];
+    VkDescriptorSetAllocateInfo ai={VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    ai.descriptorPool=s.sets; ai.descriptorSetCount=4; ai.pSetLayouts=dsl;
+    if(d.AllocateDescriptorSets(d.h,&ai,set)!=VK_SUCCESS) return false;
+    // Frame parity j: blur reads capture + history 1+j, writes history 2-j; output samples 2-j
+    VkDescriptorImageInfo ii[8];
+    VkWriteDescriptorSet wr[8];
+    for(int j=0;j<2;j++){
+        s.blurSet[j]=set[j]; s.drawSet[j]=set[2+j];
+        VkImageView v[4]={s.imgView[0],s.imgView[1+j],s.imgView[2-j],s.imgView[2-j]};
+        for(int b=0;b<4;b++){
+            int n=j*4+b;
+            ii[n]={b<3?VK_NULL_HANDLE:d.smp,v[b],VK_IMAGE_LAYOUT_GENERAL};
+            wr[n]={VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+            wr[n].dstSet=b<3?s.blurSet[j]:s.drawSet[j]; wr[n].dstBinding=b<3?b:0; wr[n].descriptorCount=1;
+            wr[n].descriptorType=b<3?VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            wr[n].pImageInfo=&ii[n];
+        }
+    }
+    d.UpdateDescriptorSets(d.h,8,wr,0,0);
+    s.fresh=true;
+    LOG("vulkan: %ux%u -> %ux%u internal",s.ext.width,s.ext.height,s.w,s.h);
+    return true;
+}
+
+static void freeInternal(Swapchain& s){
+    Device& d=*s.d;
+    d.DestroyDescriptorPool(d.h,s.sets,0); s.sets=0;
+    for(int i=0;i<3;i++){
+        d.DestroyImageView(d.h,s.imgView[i],0); d.DestroyImage(d.h,s.img[i],0); d.FreeMemory(d.h,s.imgMem[i],0);
+        s.imgView[i]=0; s.img[i]=0; s.imgMem[i]=0;
+    }
+}
+
+// Output render pass and pipeline for the swapchain format, views and framebuffers per image.
+// The pass overwrites every pixel, so the attachment is never loaded.
+static bool buildOutput(Swapchain& s){
+    Device& d=*s.d;
+    VkAttachmentDescription at={0,s.fmt,VK_SAMPLE_COUNT_1_BIT,VK_ATTACHMENT_LOAD_OP_DONT_CARE,VK_ATTACHMENT_STORE_OP_STORE,
+                                VK_ATTACHMENT_LOAD_OP_DONT_CARE,VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+    VkAttachmentReference ref={0,VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription sub={0,VK_PIPELINE_BIND_POINT_GRAPHICS,0,0,1,&ref};
+    VkRenderPassCreateInfo rc={VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+    rc.attachmentCount=1; rc.pAttachments=&at; rc.subpassCount=1; rc.pSubpasses=&sub;
+    if(d.CreateRenderPass(d.h,&rc,0,&s.pass)!=VK_SUCCESS) return false;
+
+    VkPipelineShaderStageCreateInfo st[2]={
+        {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,0,0,VK_SHADER_STAGE_VERTEX_BIT,d.vs,"main",0},
+        {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,0,0,VK_SHADER_STAGE_FRAGMENT_BIT,d.fs,"main",0}};
+    VkPipelineVertexInputStateCreateInfo vi={VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+    VkPipelineInputAssemblyStateCreateInfo ia={VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+    ia.topology=VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPipelineViewportStateCreateInfo vp={VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+    vp.viewportCount=vp.scissorCount=1;
+    VkPipelineRasterizationStateCreateInfo rs={VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+    rs.polygonMode=VK_POLYGON_MODE_FILL; rs.cullMode=VK_CULL_MODE_NONE; rs.lineWidth=1;
+    VkPipelineMultisampleStateCreateInfo ms={VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+    ms.rasterizationSamples=VK_SAMPLE_COUNT_1_BIT;
+    VkPipelineColorBlendAttachmentState ba={};
+    ba.colorWriteMask=VK_COLOR_COMPONENT_R_BIT|VK_COLOR_COMPONENT_G_BIT|VK_COLOR_COMPONENT_B_BIT|VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo cb={VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+    cb.attachmentCount=1; cb.pAttachments=&ba;
+    VkDynamicState dyn[]={VK_DYNAMIC_STATE_VIEWPORT,VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo ds={VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+    ds.dynamicStateCount=2; ds.pDynamicStates=dyn;
+    VkGraphicsPipelineCreateInfo gi={VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+    gi.stageCount=2; gi.pStages=st; gi.pVertexInputState=&vi; gi.pInputAssemblyState=&ia; gi.pViewportState=&vp;
+    gi.pRasterizationState=&rs; gi.pMultisampleState=&ms; gi.pColorBlendState=&cb; gi.pDynamicState=&ds;
+    gi.layout=d.drawLayout; gi.renderPass=s.pass;
+    if(d.CreateGraphicsPipelines(d.h,VK_NULL_HANDLE,1,&gi,0,&s.drawPipe)!=VK_SUCCESS) return false;
+
+    for(VkImage img:s.images){
+        VkImageView v=makeView(d,img,s.fmt);
+        VkFramebufferCreateInfo fc={VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+        fc.renderPass=s.pass; fc.attachmentCount=1; fc.pAttachments=&v;
+        fc.width=s.ext.width; fc.height=s.ext.height; fc.layers=1;
+        VkFramebuffer fb=0; d.CreateFramebuffer(d.h,&fc,0,&fb);
+        s.views.push_back(v); s.fbs.push_back(fb);
+    }
+    return true;
+}
+
+// Command buffers come from a pool of the presenting queue's family, made on first present
+static bool buildCommands(Swapchain& s, uint32_t family){
+    Device& d=*s.d;
+    VkCommandPoolCreateInfo pc={VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    pc.flags=VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; pc.queueFamilyIndex=family;
+    if(d.CreateCommandPool(d.h,&pc,0,&s.pool)!=VK_SUCCESS) return false;
+    s.poolFamily=family;
+    size_t n=s.images.size();
+    s.cmd.resize(n); s.fence.resize(n); s.done.resize(n);
+    VkCommandBufferAllocateInfo ai={VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    ai.commandPool=s.pool; ai.level=VK_COMMAND_BUFFER_LEVEL_PRIMARY; ai.commandBufferCount=(uint32_t)n;
+    if(d.AllocateCommandBuffers(d.h,&ai,s.cmd.data())!=VK_SUCCESS) return false;
+    VkFenceCreateInfo fc={VK_STRUCTURE_TYPE_FENCE_CREATE_INFO}; fc.flags=VK_FENCE_CREATE_SIGNALED_BIT;
+    VkSemaphoreCreateInfo sc={VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    for(size_t i=0;i<n;i++){
+        d.setData(d.h,s.cmd[i]);
+        d.CreateFence(d.h,&fc,0,&s.fence[i]); d.CreateSemaphore(d.h,&sc,0,&s.done[i]);
+    }
+    return true;
+}
+
+static void waitAll(Swapchain& s){
+    Device& d=*s.d;
+    for(VkFence f:s.fence) if(f) d.WaitForFences(d.h,1,&f,VK_TRUE,UINT64_MAX);
+}
+
+static void freeSwapchain(Swapchain& s){
+    Device& d=*s.d;
+    waitAll(s);
+    freeInternal(s);
+    for(size_t i=0;i<s.fence.size();i++){ d.DestroyFence(d.h,s.fence[i],0); d.DestroySemaphore(d.h,s.done[i],0); }
+    d.DestroyCommandPool(d.h,s.pool,0);
+    for(size_t i=0;i<s.views.size();i++){ d.DestroyFramebuffer(d.h,s.fbs[i],0); d.DestroyImageView(d.h,s.views[i],0); }
+    d.DestroyPipeline(d.h,s.drawPipe,0);
+    d.DestroyRenderPass(d.h,s.pass,0);
+}
+
+// =============================================================
+// 4. PRESENT
+// =============================================================
+static VkImageMemoryBarrier barrier(VkImage img, VkImageLayout from, VkImageLayout to, VkAccessFlags src, VkAccessFlags dst){
+    return {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,0,src,dst,from,to,VK_QUEUE_FAMILY_IGNORED,VK_QUEUE_FAMILY_IGNORED,img,{VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1}};
+}
+
+// Capture -> blur -> output into swapchain image i. The app's semaphores are
+// waited on by our submit, the present waits on ours instead.
+static void record(Swapchain& s, uint32_t i, const Config& c){
+    Device& d=*s.d;
+    VkCommandBuffer cb=s.cmd[i];
+    int j=s.frame&1;
+    VkImage img=s.images[i], cur=s.img[0], prev=s.img[1+j], next=s.img[2-j];
+    d.ResetCommandBuffer(cb,0);
+    VkCommandBufferBeginInfo bi={VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    bi.flags=VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    d.BeginCommandBuffer(cb,&bi);
+
+    // 1. Capture: one linear blit from the app's image down to the internal resolution.
+    // The previous frame's passes may still read the capture image (WAR only).
+    VkImageMemoryBarrier b1[]={
+        barrier(img,VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,0,VK_ACCESS_TRANSFER_READ_BIT),
+        barrier(cur,VK_IMAGE_LAYOUT_UNDEFINED,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,0,VK_ACCESS_TRANSFER_WRITE_BIT)};
+    d.CmdPipelineBarrier(cb,VK_PIPELINE_STAGE_TRANSFER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,VK_PIPELINE_STAGE_TRANSFER_BIT,0,0,0,0,0,2,b1);
+    VkImageBlit bl={{VK_IMAGE_ASPECT_COLOR_BIT,0,0,1},{{0,0,0},{(int32_t)s.ext.width,(int32_t)s.ext.height,1}},
+                    {VK_IMAGE_ASPECT_COLOR_BIT,0,0,1},{{0,0,0},{(int32_t)s.w,(int32_t)s.h,1}}};
+    d.CmdBlitImage(cb,img,VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,cur,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,1,&bl,VK_FILTER_LINEAR);
+
+    // 2. Blur: history written by the last dispatch becomes readable, the other one is overwritten
+    VkImageMemoryBarrier b2[]={
+        barrier(cur,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,VK_IMAGE_LAYOUT_GENERAL,VK_ACCESS_TRANSFER_WRITE_BIT,VK_ACCESS_SHADER_READ_BIT),
+        barrier(prev,s.fresh?VK_IMAGE_LAYOUT_UNDEFINED:VK_IMAGE_LAYOUT_GENERAL,VK_IMAGE_LAYOUT_GENERAL,VK_ACCESS_SHADER_WRITE_BIT,VK_ACCESS_SHADER_READ_BIT),
+        barrier(next,VK_IMAGE_LAYOUT_UNDEFINED,VK_IMAGE_LAYOUT_GENERAL,0,VK_ACCESS_SHADER_WRITE_BIT)};
+    d.CmdPipelineBarrier(cb,VK_PIPELINE_STAGE_TRANSFER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT|VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,0,0,0,0,0,3,b2);
+    BlurPush bp={c.maskInner,c.maskOuter,(float)s.ext.width/s.ext.height,c.maskShape,s.fresh,s.srgb};
+    d.CmdBindPipeline(cb,VK_PIPELINE_BIND_POINT_COMPUTE,d.blurPipe);
+    d.CmdBindDescriptorSets(cb,VK_PIPELINE_BIND_POINT_COMPUTE,d.blurLayout,0,1,&s.blurSet[j],0,0);
+    d.CmdPushConstants(cb,d.blurLayout,VK_SHADER_STAGE_COMPUTE_BIT,0,sizeof(bp),&bp);
+    d.CmdDispatch(cb,(s.w+7)/8,(s.h+7)/8,1);
+
+    // 3. Output: upscale + CAS straight into the swapchain image
+    VkImageMemoryBarrier b3[]={
+        barrier(next,VK_IMAGE_LAYOUT_GENERAL,VK_IMAGE_LAYOUT_GENERAL,VK_ACCESS_SHADER_WRITE_BIT,VK_ACCESS_SHADER_READ_BIT),
+        barrier(img,VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,0,VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT)};
+    d.CmdPipelineBarrier(cb,VK_PIPELINE_STAGE_TRANSFER_BIT|VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT|VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,0,0,0,0,0,2,b3);
+    VkRenderPassBeginInfo rp={VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+    rp.renderPass=s.pass; rp.framebuffer=s.fbs[i]; rp.renderArea={{0,0},s.ext};
+    d.CmdBeginRenderPass(cb,&rp,VK_SUBPASS_CONTENTS_INLINE);
+    VkViewport vp={0,0,(float)s.ext.width,(float)s.ext.height,0,1};
+    d.CmdSetViewport(cb,0,1,&vp); d.CmdSetScissor(cb,0,1,&rp.renderArea);
+    d.CmdBindPipeline(cb,VK_PIPELINE_BIND_POINT_GRAPHICS,s.drawPipe);
+    d.CmdBindDescriptorSets(cb,VK_PIPELINE_BIND_POINT_GRAPHICS,d.drawLayout,0,1,&s.drawSet[j],0,0);
+    DrawPush dp={c.sharpen,s.srgb};
+    d.CmdPushConstants(cb,d.drawLayout,VK_SHADER_STAGE_FRAGMENT_BIT,0,sizeof(dp),&dp);
+    d.CmdDraw(cb,3,1,0,0);
+    d.CmdEndRenderPass(cb);   // final layout PRESENT_SRC_KHR
+    d.EndCommandBuffer(cb);
+}
+
+// The lock only covers the lookups. The app synchronizes a swapchain with its
+// presents, so its state is ours until we return, and the fence waits below
+// don't stall other threads' presents or swapchain creation.
+static VkResult VKAPI_CALL QueuePresentKHR(VkQueue q, const VkPresentInfoKHR* pi){
+    Device* dp; Swapchain* sp=0; uint32_t family=0;
+    {
+        std::lock_guard<std::mutex> g(lock);
+        dp=devices[key(q)];
+        // One swapchain per present (the common case) on a queue that can run compute and graphics
+        auto fam=dp->family.find(q);
+        auto it=pi->swapchainCount==1 ? swapchains.find(pi->pSwapchains[0]) : swapchains.end();
+        if(fam!=dp->family.end() && it!=swapchains.end()){ sp=it->second; family=fam->second; }
+    }
+    Device& d=*dp;
+    if(!sp) return d.QueuePresentKHR(q,pi);
+    Swapchain& s=*sp;
+    if(!s.pool && !buildCommands(s,family)){
+        LOG("vulkan: command setup failed, passing through");
+        { std::lock_guard<std::mutex> g(lock); swapchains.erase(pi->pSwapchains[0]); }
+        freeSwapchain(s); delete &s;
+        return d.QueuePresentKHR(q,pi);
+    }
+    if(s.poolFamily!=family) return d.QueuePresentKHR(q,pi);
+
+    Config c=config.load();
+    if(c.scale!=s.scale){
+        if(c.scale==s.failed) return d.QueuePresentKHR(q,pi);
+        waitAll(s); freeInternal(s);
+        if(!buildInternal(s,c.scale)){
+            LOG("vulkan: out of memory for %ux%u, passing through until the scale changes",s.w,s.h);
+            freeInternal(s); s.scale=0; s.failed=c.scale;
+            return d.QueuePresentKHR(q,pi);
+        }
+        s.failed=0;
+    }
+    uint32_t i=pi->pImageIndices[0];
+    d.WaitForFences(d.h,1,&s.fence[i],VK_TRUE,UINT64_MAX);
+    d.ResetFences(d.h,1,&s.fence[i]);
+    record(s,i,c);
+
+    std::vector<VkPipelineStageFlags> stages(pi->waitSemaphoreCount,VK_PIPELINE_STAGE_TRANSFER_BIT);
+    VkSubmitInfo si={VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    si.waitSemaphoreCount=pi->waitSemaphoreCount; si.pWaitSemaphores=pi->pWaitSemaphores; si.pWaitDstStageMask=stages.data();
+    si.commandBufferCount=1; si.pCommandBuffers=&s.cmd[i];
+    si.signalSemaphoreCount=1; si.pSignalSemaphores=&s.done[i];
+    VkResult r=d.QueueSubmit(q,1,&si,s.fence[i]);
+    if(r!=VK_SUCCESS) return r;
+    s.frame++; s.fresh=false;
+    VkPresentInfoKHR p=*pi;
+    p.waitSemaphoreCount=1; p.pWaitSemaphores=&s.done[i];
+    return d.QueuePresentKHR(q,&p);
+}
+
+// =============================================================
+// 5. SWAPCHAINS
+// =============================================================
+// Our capture needs the images as a blit source; formats or surfaces that
+// can't offer that are left alone. As in present, the lock only covers the
+// lookup and the insert: the call down and the pipeline setup run unlocked.
+static VkResult VKAPI_CALL CreateSwapchainKHR(VkDevice dev, const VkSwapchainCreateInfoKHR* ci, const VkAllocationCallbacks* a, VkSwapchainKHR* out){
+    Device* dp;
+    { std::lock_guard<std::mutex> g(lock); dp=devices[key(dev)]; }
+    Device& d=*dp;
+    VkSurfaceCapabilitiesKHR caps={};
+    VkFormatProperties fp={};
+    if(d.inst->GetPhysicalDeviceSurfaceCapabilitiesKHR) d.inst->GetPhysicalDeviceSurfaceCapabilitiesKHR(d.gpu,ci->surface,&caps);
+    d.inst->GetPhysicalDeviceFormatProperties(d.gpu,ci->imageFormat,&fp);
+    VkFormatFeatureFlags need=VK_FORMAT_FEATURE_BLIT_SRC_BIT|VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    bool ok=(caps.supportedUsageFlags&VK_IMAGE_USAGE_TRANSFER_SRC_BIT) && (fp.optimalTilingFeatures&need)==need
+         && ci->imageArrayLayers==1 && ci->imageExtent.width>=MIN_SIZE && ci->imageExtent.height>=MIN_SIZE;
+    VkSwapchainCreateInfoKHR c=*ci;
+    if(ok) c.imageUsage|=VK_IMAGE_USAGE_TRANSFER_SRC_BIT|VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    VkResult r=d.CreateSwapchainKHR(dev,&c,a,out);
+    if(r!=VK_SUCCESS || !ok) return r;
+    { std::lock_guard<std::mutex> g(d.init); if(!deviceInit(d)) return r; }
+
+    Swapchain* s=new Swapchain();
+    s->d=&d; s->fmt=ci->imageFormat; s->srgb=isSrgb(ci->imageFormat); s->ext=ci->imageExtent;
+    uint32_t n=0; d.GetSwapchainImagesKHR(dev,*out,&n,0);
+    s->images.resize(n); d.GetSwapchainImagesKHR(dev,*out,&n,s->images.data());
+    if(!buildOutput(*s)){ LOG("vulkan: output pass setup failed for format %d",ci->imageFormat); freeSwapchain(*s); delete s; return r; }
+    { std::lock_guard<std::mutex> g(lock); swapchains[*out]=s; }
+    LOG("vulkan: swapchain %ux%u format %d%s, %u images",s->ext.width,s->ext.height,s->fmt,s->srgb?" (sRGB)":"",n);
+    return r;
+}
+
+// Unlinked under the lock, freed (fence waits included) outside it
+static void VKAPI_CALL DestroySwapchainKHR(VkDevice dev, VkSwapchainKHR sc, const VkAllocationCallbacks* a){
+    Device* d; Swapchain* s=0;
+    {
+        std::lock_guard<std::mutex> g(lock);
+        d=devices[key(dev)];
+        auto it=swapchains.find(sc);
+        if(it!=swapchains.end()){ s=it->second; swapchains.erase(it); }
+    }
+    if(s){ freeSwapchain(*s); delete s; }
+    d->DestroySwapchainKHR(dev,sc,a);
+}
+
+// =============================================================
+// 6. INSTANCE AND DEVICE
+// =============================================================
+// Tracked after the next layer (or libvulkan itself) created them; gipa and gdpa
+// resolve everything we call further down.
+static void addInstance(VkInstance h, PFN_vkGetInstanceProcAddr gipa){
+    Instance* in=new Instance();
+    in->h=h; in->gipa=gipa;
+#define X(n) in->n=(PFN_vk##n)gipa(h,"vk" #n);
+    INSTANCE_FUNCS(X)
+#undef X
+    std::lock_guard<std::mutex> g(lock);
+    instances[key(h)]=in;
+}
+
+static void VKAPI_CALL DestroyInstance(VkInstance inst, const VkAllocationCallbacks* a){
+    Instance* in;
+    { std::lock_guard<std::mutex> g(lock); in=instances[key(inst)]; instances.erase(key(inst)); }
+    in->DestroyInstance(inst,a);
+    delete in;
+}
+
+static void addDevice(Instance* in, VkPhysicalDevice gpu, const VkDeviceCreateInfo* ci, VkDevice h,
+                      PFN_vkGetDeviceProcAddr gdpa, VkResult (VKAPI_PTR *setData)(VkDevice,void*)){
+    Device* d=new Device();
+    d->h=h; d->gpu=gpu; d->inst=in; d->gdpa=gdpa; d->setData=setData;
+#define X(n) d->n=(PFN_vk##n)gdpa(h,"vk" #n);
+    DEVICE_FUNCS(X)
+#undef X
+    in->GetPhysicalDeviceMemoryProperties(gpu,&d->mem);
+    uint32_t nf=0; in->GetPhysicalDeviceQueueFamilyProperties(gpu,&nf,0);
+    std::vector<VkQueueFamilyProperties> fams(nf); in->GetPhysicalDeviceQueueFamilyProperties(gpu,&nf,fams.data());
+    VkQueueFlags need=VK_QUEUE_GRAPHICS_BIT|VK_QUEUE_COMPUTE_BIT;
+    for(uint32_t i=0;i<ci->queueCreateInfoCount;i++){
+        const VkDeviceQueueCreateInfo& qi=ci->pQueueCreateInfos[i];
+        if(qi.flags || (fams[qi.queueFamilyIndex].queueFlags&need)!=need) continue;   // protected queues: vkGetDeviceQueue2 only
+        for(uint32_t k=0;k<qi.queueCount;k++){ VkQueue q; d->GetDeviceQueue(h,qi.queueFamilyIndex,k,&q); d->family[q]=qi.queueFamilyIndex; }
+    }
+    std::lock_guard<std::mutex> g(lock);
+    devices[key(h)]=d;
+}
+
+static void VKAPI_CALL DestroyDevice(VkDevice dev, const VkAllocationCallbacks* a){
+    Device* d;
+    std::vector<Swapchain*> left;   // the app should have destroyed them; don't leak if it didn't
+    {
+        std::lock_guard<std::mutex> g(lock);
+        d=devices[key(dev)]; devices.erase(key(dev));
+        for(auto it=swapchains.begin();it!=swapchains.end();)
+            if(it->second->d==d){ left.push_back(it->second); it=swapchains.erase(it); } else ++it;
+    }
+    for(Swapchain* s:left){ freeSwapchain(*s); delete s; }
+    d->DeviceWaitIdle(dev);
+    deviceFree(*d);
+    d->DestroyDevice(dev,a);
+    delete d;
+}
+
+#ifndef VULKAN_IN_PROCESS
+// =============================================================
+// 7. LAYER ENTRY POINTS
+// =============================================================
+// The loader's link info (next layer's entry points) and callbacks ride in pNext
+template<class T> static T* chain(const void* next, VkStructureType type, VkLayerFunction fn){
+    auto* p=(T*)next;
+    while(p && !(p->sType==type && p->function==fn)) p=(T*)p->pNext;
+    return p;
+}
+
+static VkResult VKAPI_CALL CreateInstance(const VkInstanceCreateInfo* ci, const VkAllocationCallbacks* a, VkInstance* out){
+    auto* link=chain<VkLayerInstanceCreateInfo>(ci->pNext,VK_STRUCTURE_TYPE_LOADER_INSTANCE_CREATE_INFO,VK_LAYER_LINK_INFO);
+    if(!link) return VK_ERROR_INITIALIZATION_FAILED;
+    PFN_vkGetInstanceProcAddr gipa=link->u.pLayerInfo->pfnNextGetInstanceProcAddr;
+    link->u.pLayerInfo=link->u.pLayerInfo->pNext;
+    auto create=(PFN_vkCreateInstance)gipa(VK_NULL_HANDLE,"vkCreateInstance");
+    VkResult r=create(ci,a,out);
+    if(r==VK_SUCCESS) addInstance(*out,gipa);
+    return r;
+}
+
+static VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice gpu, const VkDeviceCreateInfo* ci, const VkAllocationCallbacks* a, VkDevice* out){
+    auto* link=chain<VkLayerDeviceCreateInfo>(ci->pNext,VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO,VK_LAYER_LINK_INFO);
+    auto* cb=chain<VkLayerDeviceCreateInfo>(ci->pNext,VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO,VK_LOADER_DATA_CALLBACK);
+    if(!link || !cb) return VK_ERROR_INITIALIZATION_FAILED;
+    Instance* in;
+    { std::lock_guard<std::mutex> g(lock); in=instances[key(gpu)]; }
+    PFN_vkGetInstanceProcAddr gipa=link->u.pLayerInfo->pfnNextGetInstanceProcAddr;
+    PFN_vkGetDeviceProcAddr gdpa=link->u.pLayerInfo->pfnNextGetDeviceProcAddr;
+    link->u.pLayerInfo=link->u.pLayerInfo->pNext;
+    auto create=(PFN_vkCreateDevice)gipa(in->h,"vkCreateDevice");
+    VkResult r=create(gpu,ci,a,out);
+    if(r==VK_SUCCESS) addDevice(in,gpu,ci,*out,gdpa,cb->u.pfnSetDeviceLoaderData);
+    return r;
+}
+
+static const VkLayerProperties LAYER={"VK_LAYER_MOTIONBLUR",VK_MAKE_VERSION(1,1,0),1,"Motion blur, CAS sharpening and tonemapping on every present"};
+
+static VkResult VKAPI_CALL EnumerateInstanceLayerProperties(uint32_t* n, VkLayerProperties* p){
+    if(p && *n<1) return VK_INCOMPLETE;
+    if(p) p[0]=LAYER;
+    *n=1;
+    return VK_SUCCESS;
+}
+static VkResult VKAPI_CALL EnumerateDeviceLayerProperties(VkPhysicalDevice, uint32_t* n, VkLayerProperties* p){ return EnumerateInstanceLayerProperties(n,p); }
+
+static VkResult VKAPI_CALL EnumerateInstanceExtensionProperties(const char* layer, uint32_t* n, VkExtensionProperties*){
+    if(!layer || strcmp(layer,LAYER_NAME)) return VK_ERROR_LAYER_NOT_PRESENT;
+    *n=0;
+    return VK_SUCCESS;
+}
+static VkResult VKAPI_CALL EnumerateDeviceExtensionProperties(VkPhysicalDevice gpu, const char* layer, uint32_t* n, VkExtensionProperties* p){
+    if(layer && !strcmp(layer,LAYER_NAME)){ *n=0; return VK_SUCCESS; }
+    Instance* in;
+    { std::lock_guard<std::mutex> g(lock); in=instances[key(gpu)]; }
+    return in->EnumerateDeviceExtensionProperties(gpu,layer,n,p);
+}
+
+static PFN_vkVoidFunction VKAPI_CALL GetDeviceProcAddr(VkDevice dev, const char* name);
+
+#define HOOK(n) if(!strcmp(name,"vk" #n)) return (PFN_vkVoidFunction)n;
+static PFN_vkVoidFunction deviceHook(const char* name){
+    HOOK(GetDeviceProcAddr) HOOK(DestroyDevice) HOOK(CreateSwapchainKHR) HOOK(DestroySwapchainKHR) HOOK(QueuePresentKHR)
+    return 0;
+}
+
+// Hooks are only handed out for functions the device has (swapchain enabled)
+static PFN_vkVoidFunction VKAPI_CALL GetDeviceProcAddr(VkDevice dev, const char* name){
+    PFN_vkVoidFunction next;
+    { std::lock_guard<std::mutex> g(lock); next=devices[key(dev)]->gdpa(dev,name); }
+    PFN_vkVoidFunction f=deviceHook(name);
+    return next && f ? f : next;
+}
+
+static PFN_vkVoidFunction VKAPI_CALL GetInstanceProcAddr(VkInstance inst, const char* name){
+    HOOK(GetInstanceProcAddr) HOOK(CreateInstance) HOOK(DestroyInstance) HOOK(CreateDevice)
+    HOOK(EnumerateInstanceLayerProperties) HOOK(EnumerateInstanceExtensionProperties)
+    HOOK(EnumerateDeviceLayerProperties) HOOK(EnumerateDeviceExtensionProperties)
+    if(PFN_vkVoidFunction f=deviceHook(name)) return f;
+    if(!inst) return 0;
+    std::lock_guard<std::mutex> g(lock);
+    return instances[key(inst)]->gipa(inst,name);
+}
+#undef HOOK
+
+// Desktop loaders negotiate; Android's looks the entry points up by name
+EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkNegotiateLoaderLayerInterfaceVersion(VkNegotiateLayerInterface* v){
+    if(v->loaderLayerInterfaceVersion>2) v->loaderLayerInterfaceVersion=2;
+    v->pfnGetInstanceProcAddr=GetInstanceProcAddr;
+    v->pfnGetDeviceProcAddr=GetDeviceProcAddr;
+    v->pfnGetPhysicalDeviceProcAddr=0;
+    return VK_SUCCESS;
+}
+EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance i, const char* n){ return GetInstanceProcAddr(i,n); }
+EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice d, const char* n){ return GetDeviceProcAddr(d,n); }
+EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceLayerProperties(uint32_t* n, VkLayerProperties* p){ return EnumerateInstanceLayerProperties(n,p); }
+EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceExtensionProperties(const char* l, uint32_t* n, VkExtensionProperties* p){ return EnumerateInstanceExtensionProperties(l,n,p); }
+EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateDeviceLayerProperties(VkPhysicalDevice g, uint32_t* n, VkLayerProperties* p){ return EnumerateDeviceLayerProperties(g,n,p); }
+EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateDeviceExtensionProperties(VkPhysicalDevice g, const char* l, uint32_t* n, VkExtensionProperties* p){ return EnumerateDeviceExtensionProperties(g,l,n,p); }
+
+// =============================================================
+// 8. STARTUP
+// =============================================================
+static void* watcher(void*){
+    const char* path=getenv(CONFIG_ENV);
+    if(!path) return 0;
+    for(time_t seen=0;;sleep(1)){
+        struct stat st;
+        if(stat(path,&st)==0 && st.st_mtime!=seen){
+            Config c; seen=st.st_mtime;
+            if(loadConfig(path,c)){ pthread_mutex_lock(&configWrite); config.store(c); pthread_mutex_unlock(&configWrite); LOG("vulkan: config %s loaded",path); }
+        }
+    }
+    return 0;
+}
+
+__attribute__((constructor)) static void init(){ pthread_t t; if(pthread_create(&t,0,watcher,0)==0) pthread_detach(t); }
+
+#else
+// =============================================================
+// 9. IN-PROCESS HOOKS
+// =============================================================
+// A shipped Android app loads no layers, so libvulkan's own exports are patched.
+// The trampolines stand in for the next layer; what resolves through them is
+// libvulkan's internal entry points, which never come back here. Handles created
+// before the patch (or on instances we missed) pass straight through.
+#define HOOKED_FUNCS(X) X(GetInstanceProcAddr) X(GetDeviceProcAddr) X(CreateInstance) X(DestroyInstance) X(CreateDevice) \
+    X(DestroyDevice) X(CreateSwapchainKHR) X(DestroySwapchainKHR) X(QueuePresentKHR)
+
+static struct {
+#define X(n) PFN_vk##n n;
+    HOOKED_FUNCS(X)
+#undef X
+} orig;
+
+static bool known(void* k){ std::lock_guard<std::mutex> g(lock); return instances.count(k) || devices.count(k); }
+
+// libvulkan's vkAllocateCommandBuffers already sets the dispatch pointer
+static VkResult VKAPI_CALL ownDispatch(VkDevice, void*){ return VK_SUCCESS; }
+
+static VkResult VKAPI_CALL hCreateInstance(const VkInstanceCreateInfo* ci, const VkAllocationCallbacks* a, VkInstance* out){
+    VkResult r=orig.CreateInstance(ci,a,out);
+    if(r==VK_SUCCESS) addInstance(*out,orig.GetInstanceProcAddr);
+    return r;
+}
+static void VKAPI_CALL hDestroyInstance(VkInstance h, const VkAllocationCallbacks* a){ known(key(h))?DestroyInstance(h,a):orig.DestroyInstance(h,a); }
+
+static VkResult VKAPI_CALL hCreateDevice(VkPhysicalDevice gpu, const VkDeviceCreateInfo* ci, const VkAllocationCallbacks* a, VkDevice* out){
+    Instance* in=0;
+    { std::lock_guard<std::mutex> g(lock); auto it=instances.find(key(gpu)); if(it!=instances.end()) in=it->second; }
+    VkResult r=orig.CreateDevice(gpu,ci,a,out);
+    if(r==VK_SUCCESS && in) addDevice(in,gpu,ci,*out,orig.GetDeviceProcAddr,ownDispatch);
+    return r;
+}
+static void VKAPI_CALL hDestroyDevice(VkDevice h, const VkAllocationCallbacks* a){ known(key(h))?DestroyDevice(h,a):orig.DestroyDevice(h,a); }
+
+static VkResult VKAPI_CALL hCreateSwapchainKHR(VkDevice h, const VkSwapchainCreateInfoKHR* ci, const VkAllocationCallbacks* a, VkSwapchainKHR* out){
+    return known(key(h))?CreateSwapchainKHR(h,ci,a,out):orig.CreateSwapchainKHR(h,ci,a,out);
+}
+static void VKAPI_CALL hDestroySwapchainKHR(VkDevice h, VkSwapchainKHR sc, const VkAllocationCallbacks* a){
+    known(key(h))?DestroySwapchainKHR(h,sc,a):orig.DestroySwapchainKHR(h,sc,a);
+}
+static VkResult VKAPI_CALL hQueuePresentKHR(VkQueue q, const VkPresentInfoKHR* pi){ return known(key(q))?QueuePresentKHR(q,pi):orig.QueuePresentKHR(q,pi); }
+
+// Pointers the app looks up (volk and most engines do) are libvulkan's internal
+// ones, not the patched exports, so the lookups hand out ours too
+static PFN_vkVoidFunction hooked(const char* name);
+static PFN_vkVoidFunction VKAPI_CALL hGetInstanceProcAddr(VkInstance h, const char* name){
+    PFN_vkVoidFunction next=orig.GetInstanceProcAddr(h,name), f=hooked(name);
+    return next && f ? f : next;
+}
+static PFN_vkVoidFunction VKAPI_CALL hGetDeviceProcAddr(VkDevice h, const char* name){
+    PFN_vkVoidFunction next=orig.GetDeviceProcAddr(h,name), f=hooked(name);
+    return next && f ? f : next;
+}
+static PFN_vkVoidFunction hooked(const char* name){
+#define X(n) if(!strcmp(name,"vk" #n)) return (PFN_vkVoidFunction)h##n;
+    HOOKED_FUNCS(X)
+#undef X
+    return 0;
+}
+
+bool vulkanHook(void* (*find)(const char*), void (*hook)(void* at, void* repl, void** orig)){
+    static const char* names[]={
+#define X(n) "vk" #n,
+        HOOKED_FUNCS(X)
+#undef X
+    };
+    void* repl[]={
+#define X(n) (void*)h##n,
+        HOOKED_FUNCS(X)
+#undef X
+    };
+    void** slot[]={
+#define X(n) (void**)&orig.n,
+        HOOKED_FUNCS(X)
+#undef X
+    };
+    const int c=sizeof(names)/sizeof(*names);
+    void* at[c];
+    for(int i=0;i<c;i++) if(!(at[i]=find(names[i]))) return false;
+    for(int i=0;i<c;i++) hook(at[i],repl[i],slot[i]);
+    LOG("vulkan: libvulkan hooked");
+    return true;
+}
+#endif
@@ -0,0 +1,7 @@
+#pragma once
+
+// Vulkan games on Android: the layer's passes (VulkanLayer.cpp, built with
+// VULKAN_IN_PROCESS) patched over libvulkan's exports, since a shipped app loads
+// no layers. find resolves a libvulkan symbol, hook patches it and returns the
+// original through orig. Nothing is patched unless every symbol resolves.
+bool vulkanHook(void* (*find)(const char*), void (*hook)(void* at, void* repl, void** orig));
@@ -0,0 +1,179 @@
+#include "Workers.h"
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+
+#include "Log.h"
+
+// =============================================================
+// 1. SETTINGS
+// =============================================================
+static const int THREADS = 2;            // an encode and a file write can overlap; more would only take game cores
+static const int MAX_LANES = 8;          // posting threads alive at once (render, control, main, ...)
+static const uint32_t LANE_SIZE = 64;    // items per lane and priority, power of two
+static const bool LITTLE_CORES = true;   // pin workers to the slowest cluster (cpu_capacity, else max frequency)
+static const int NICE = 5;               // below the game's threads when a little core is contended
+
+// =============================================================
+// 2. LANES
+// =============================================================
+// Bounded ring with one producer and any number of consumers. Each slot's
+// sequence says whose turn it is: seq == i, push i may write it; seq == i+1,
+// it holds push i for a consumer to claim (CAS on tail), which hands it back
+// as i+N once it has copied the item out.
+struct WorkItem { void (*fn)(void*); void* arg; };
+
+struct Ring {
+    struct Slot { std::atomic<uint32_t> seq; WorkItem w; };
+    Slot s[LANE_SIZE];
+    alignas(64) uint32_t head=0;                 // the owning thread only
+    alignas(64) std::atomic<uint32_t> tail{0};   // workers
+
+    Ring(){ for(uint32_t i=0;i<LANE_SIZE;i++) s[i].seq.store(i,std::memory_order_relaxed); }
+
+    bool push(const WorkItem& w){
+        Slot& x=s[head%LANE_SIZE];
+        if(x.seq.load(std::memory_order_acquire)!=head) return false;   // full
+        x.w=w; x.seq.store(head+1,std::memory_order_release); head++;
+        return true;
+    }
+
+    bool take(WorkItem& w){
+        uint32_t t=tail.load(std::memory_order_relaxed);
+        for(;;){
+            Slot& x=s[t%LANE_SIZE];
+            int32_t d=(int32_t)(x.seq.load(std::memory_order_acquire)-(t+1));
+            if(d<0) return false;                                       // empty
+            if(d>0){ t=tail.load(std::memory_order_relaxed); continue; }   // another worker got there first
+            if(tail.compare_exchange_weak(t,t+1,std::memory_order_relaxed)){
+                w=x.w; x.seq.store(t+LANE_SIZE,std::memory_order_release);
+                return true;
+            }
+        }
+    }
+};
+
+struct Lane { Ring ring[WORK_PRIORITIES]; };
+static Lane lanes[MAX_LANES];
+static std::atomic<int> laneCount{0};   // lanes ever handed out, all of them scanned by the workers
+static thread_local int myLane=-1;
+
+// A thread's first post claims a lane (the only lock on this path); its exit
+// hands the lane back for the next thread, items still queued included: the
+// workers keep draining it and the next owner pushes behind them.
+static pthread_mutex_t laneLock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t laneKey;
+static int freeLanes[MAX_LANES], freeCount=0;
+
+static void releaseLane(void* v){
+    pthread_mutex_lock(&laneLock);
+    freeLanes[freeCount++]=(int)(intptr_t)v-1;
+    pthread_mutex_unlock(&laneLock);
+}
+
+static int claimLane(){
+    static pthread_once_t once=PTHREAD_ONCE_INIT;
+    pthread_once(&once,[]{ pthread_key_create(&laneKey,releaseLane); });
+    int i=-1;
+    pthread_mutex_lock(&laneLock);
+    if(freeCount) i=freeLanes[--freeCount];
+    else if((i=laneCount.load(std::memory_order_relaxed))<MAX_LANES) laneCount.store(i+1,std::memory_order_release);
+    else i=-1;
+    pthread_mutex_unlock(&laneLock);
+    if(i>=0) pthread_setspecific(laneKey,(void*)(intptr_t)(i+1));
+    return i;
+}
+
+// Workers sleep on `wake`; posting bumps it and wakes one if any sleeps
+static std::atomic<uint32_t> wake{0};
+static std::atomic<int> sleepers{0};
+static std::atomic<bool> running{false};
+
+static long futex(std::atomic<uint32_t>* a, int op, uint32_t v){ return syscall(SYS_futex,(uint32_t*)a,op|FUTEX_PRIVATE_FLAG,v,0,0,0); }
+
+bool workPost(void (*fn)(void*), void* arg, WorkPriority p){
+    if(!running.load(std::memory_order_acquire)) return false;
+    if(myLane<0 && (myLane=claimLane())<0){
+        static thread_local bool told=false;   // tried again on the next post, a lane may have come free
+        if(!told){ told=true; LOG("workers: %d threads already post, none left for this one",MAX_LANES); }
+        return false;
+    }
+    if(!lanes[myLane].ring[p].push({fn,arg})) return false;
+    wake.fetch_add(1,std::memory_order_seq_cst);
+    if(sleepers.load(std::memory_order_seq_cst)) futex(&wake,FUTEX_WAKE,1);
+    return true;
+}
+
+// Most urgent first; worker i starts at lane i so two workers don't race for the same item
+static bool next(int self, WorkItem& w){
+    int n=laneCount.load(std::memory_order_acquire);
+    for(int p=0;p<WORK_PRIORITIES;p++)
+        for(int k=0;k<n;k++) if(lanes[(self+k)%n].ring[p].take(w)) return true;
+    return false;
+}
+
+// =============================================================
+// 3. THREADS
+// =============================================================
+// The slowest cluster, by cpu_capacity where the kernel has it, else by
+// cpuinfo_max_freq; empty when every core is the same
+static bool littleSet(cpu_set_t& set){
+    static const char* keys[2]={"cpu_capacity","cpufreq/cpuinfo_max_freq"};
+    int cpus=(int)sysconf(_SC_NPROCESSORS_CONF); if(cpus>CPU_SETSIZE) cpus=CPU_SETSIZE;
+    for(const char* key:keys){
+        long v[CPU_SETSIZE]; long lo=LONG_MAX, hi=0; int found=0;
+        for(int c=0;c<cpus;c++){
+            char path[96]; snprintf(path,sizeof(path),"/sys/devices/system/cpu/cpu%d/%s",c,key);
+            FILE* f=fopen(path,"r"); v[c]=-1;
+            if(f){ if(fscanf(f,"%ld",&v[c])!=1) v[c]=-1; fclose(f); }
+            if(v[c]<0) continue;
+            found++; if(v[c]<lo) lo=v[c]; if(v[c]>hi) hi=v[c];
+        }
+        if(!found || lo==hi) continue;
+        CPU_ZERO(&set);
+        for(int c=0;c<cpus;c++) if(v[c]==lo) CPU_SET(c,&set);
+        return true;
+    }
+    return false;
+}
+
+void workPinLittle(){
+    if(!LITTLE_CORES) return;
+    static cpu_set_t set;
+    static const bool have=littleSet(set);
+    if(have) sched_setaffinity(0,sizeof(set),&set);
+}
+
+static void* workerThread(void* a){
+    int self=(int)(intptr_t)a;
+    workPinLittle();
+    setpriority(PRIO_PROCESS,(id_t)syscall(SYS_gettid),NICE);
+    for(;;){
+        uint32_t seen=wake.load(std::memory_order_seq_cst);
+        WorkItem w;
+        if(next(self,w)){ w.fn(w.arg); continue; }
+        sleepers.fetch_add(1,std::memory_order_seq_cst);
+        futex(&wake,FUTEX_WAIT,seen);   // returns at once if anything was posted since `seen`
+        sleepers.fetch_sub(1,std::memory_order_seq_cst);
+    }
+    return 0;
+}
+
+void workersStart(){
+    static pthread_once_t once=PTHREAD_ONCE_INIT;
+    pthread_once(&once,[]{
+        int up=0;
+        for(int i=0;i<THREADS;i++){
+            pthread_t t;
+            if(pthread_create(&t,0,workerThread,(void*)(intptr_t)i)==0){ pthread_detach(t); up++; }
+        }
+        if(up) running.store(true,std::memory_order_release);
+        LOG("workers: %d threads",up);
+    });
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+
+// =============================================================
+// WORKERS: the mod's threads for everything that isn't GL
+// =============================================================
+// A few threads on the little cores take encoding, file I/O and other work
+// the render thread must not wait for. Every posting thread owns a lane, a
+// bounded ring per priority: posting is one slot write and one store, never
+// a lock or a retry loop (and a futex wake only when a worker sleeps). The
+// lane is claimed on the first post and handed back when the thread exits. Idle
+// workers take from the far end of whichever lane has the most urgent work.
+// Nothing is ordered across items; work that must stay in order keeps its own
+// queue and posts one item to drain it (Recorder.cpp).
+// Workers never post, so there are no per-worker deques to steal from: the
+// lanes' far ends are the only place work waits, and every worker steals from
+// all of them. Pinning is per pool, not per item: everything here is background
+// work, and a worker on the big cores would compete with the game's own threads.
+enum WorkPriority { WORK_URGENT, WORK_NORMAL, WORK_IDLE, WORK_PRIORITIES };
+
+// Starts the pool (once; later calls do nothing)
+void workersStart();
+// fn(arg) on some worker. False (not queued) if the pool isn't up, this
+// thread's lane is full at that priority, or every lane is owned by a live thread.
+bool workPost(void (*fn)(void*), void* arg, WorkPriority p=WORK_NORMAL);
+// Moves the calling thread onto the little cores, if the device has any
+void workPinLittle();
+
+// A typed job with one completion slot, owned by the thread that posts it. The
+// worker stores fn(in) in out and marks it done; the owner poll()s once a frame
+// and gets the result exactly once, after which the task can be posted again.
+enum { TASK_FREE, TASK_QUEUED, TASK_DONE };
+template<class In, class Out> struct WorkTask {
+    Out (*fn)(const In&);
+    In in{};
+    Out out{};
+    std::atomic<int> state{TASK_FREE};
+
+    explicit WorkTask(Out (*f)(const In&)):fn(f){}
+
+    bool busy() const { return state.load(std::memory_order_acquire)==TASK_QUEUED; }
+    // False if the last result wasn't collected yet or nothing could be queued
+    bool post(const In& v, WorkPriority p=WORK_NORMAL){
+        if(state.load(std::memory_order_acquire)!=TASK_FREE) return false;
+        in=v; state.store(TASK_QUEUED,std::memory_order_relaxed);
+        if(workPost(run,this,p)) return true;
+        state.store(TASK_FREE,std::memory_order_relaxed);
+        return false;
+    }
+    // The result, once; valid until the next post()
+    const Out* poll(){
+        if(state.load(std::memory_order_acquire)!=TASK_DONE) return 0;
+        state.store(TASK_FREE,std::memory_order_relaxed);
+        return &out;
+    }
+
+private:
+    static void run(void* p){
+        WorkTask* t=(WorkTask*)p;
+        t->out=t->fn(t->in);
+        t->state.store(TASK_DONE,std::memory_order_release);
+    }
+};
@@ -1,214 +1,728 @@
 #include <jni.h>
-#include <android/log.h>
+#include <android/api-level.h>
+#include <android/native_window.h>
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 #include <GLES3/gl3.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <dlfcn.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <new>
 #include <cmath>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
 
 #include "pl/Hook.h"
 #include "pl/Gloss.h"
+#include "Log.h"
+#include "Config.h"
+#include "Pipeline.h"
+#include "Seqlock.h"
+#include "Telemetry.h"
+#include "Histogram.h"
+#include "Latency.h"
+#include "Stats.h"
+#include "AbTest.h"
+#include "Control.h"
+#include "Recorder.h"
+#include "FrameDump.h"
+#include "Governor.h"
+#include "PresentChain.h"
+#include "Workers.h"
+#include "GLState.h"
+#include "Redirect.h"
+#include "VulkanLayer.h"
 
 // =============================================================
-// 1. FINAL SETTINGS
+// 1. FINAL SETTINGS (pipeline settings: Config.h)
 // =============================================================
-static const float SCALE = 0.5f;          // 50% Internal Resolution (Max Performance)
-static const float MAX_BLUR = 0.94f;      // 94% Smoothness (Walking/Looking around)
-static const float MIN_BLUR = 0.35f;      // 35% Smoothness (Fast PvP Flicks)
-static const float SHARPEN = 0.88f;       // 88% CAS Sharpening (HD Clarity)
+static const char* CONFIG_PATH = "/sdcard/games/com.mojang/motionblur.cfg";
+static const char* TRACE_PATH = "/sdcard/games/com.mojang/motionblur.trace";
+static const char* TRACE_JSON_PATH = "/sdcard/games/com.mojang/motionblur.json";
+static const char* STATS_PATH = "/sdcard/games/com.mojang/motionblur.stats";   // read with tools/mbstat
+static const char* RECORD_DIR = "/sdcard/games/com.mojang";   // screenshots (.png) and clips (.y4m)
+static const char* DUMP_PATH = "/sdcard/games/com.mojang/motionblur.ring";   // frame dump ring (dump_seconds); the last session's stays as .prev
+static const char* CONTROL_NAME = "motionblur";   // abstract unix socket (adb forward tcp:N localabstract:motionblur)
+static const bool PRESENT_CHAIN = true;   // share one swap hook with other mods (PresentChain.h): host it, or join theirs
+static const int PRESENT_ORDER = 0;       // our place in that chain, lower runs first
 
 // =============================================================
-// 2. SHADERS (Verified & Optimized)
+// 4. GAME RESOLUTION REDIRECT: Redirect.cpp (the h* framebuffer hooks)
 // =============================================================
 
-const char* vert = R"(#version 300 es
-layout(location=0) in vec4 p; layout(location=1) in vec2 t; out mediump vec2 v;
-void main(){gl_Position=p;v=t;})";
-
-// --- PASS 1: VELOCITY ACCUMULATION ---
-const char* frag_blur = R"(#version 300 es
-precision mediump float;
-in mediump vec2 v;
-uniform sampler2D c; // Current Frame
-uniform sampler2D h; // History Frame
-out vec4 o;
-
-void main() {
-    lowp vec4 curr = texture(c, v);
-    lowp vec4 hist = texture(h, v);
-
-    // 1. VELOCITY CALCULATOR (Anti-Ghosting)
-    lowp float lC = dot(curr.rgb, vec3(0.299, 0.587, 0.114));
-    lowp float lH = dot(hist.rgb, vec3(0.299, 0.587, 0.114));
-    lowp float diff = abs(lC - lH);
-
-    // Dynamic Interpolation:
-    // Low Diff (Walking) -> Max Blur (0.94)
-    // High Diff (Flicking) -> Min Blur (0.35)
-    lowp float velocity = smoothstep(0.02, 0.30, diff);
-    lowp float factor = mix(0.94, 0.35, velocity);
-
-    // 2. SHADOW PROTECTION (Contrast Fix)
-    // If history is darker than current, we favor it slightly.
-    // This prevents shadows from turning gray during movement.
-    lowp vec4 result = mix(curr, hist, factor);
-    if (lH < lC) { 
-        result = mix(result, hist, 0.05); 
-    }
-
-    // 3. CENTER MASK (PvP Aim)
-    // Protects the crosshair area (Radius 0.12)
-    mediump vec2 center = vec2(0.5);
-    lowp float dist = distance(v, center);
-    lowp float mask = smoothstep(0.01, 0.12, dist);
-
-    o = mix(curr, result, mask);
-})";
-
-// --- PASS 2: CLARITY & OUTPUT ---
-const char* frag_draw = R"(#version 300 es
-precision mediump float;
-in mediump vec2 v;
-uniform sampler2D t;
-out vec4 o;
-
-void main() {
-    // 1. CAS SHARPENING (Contrast Adaptive Sharpening)
-    lowp vec4 col = texture(t, v);
-    
-    // Read 4 neighbors
-    lowp vec4 n = textureOffset(t, v, ivec2(0, -1));
-    lowp vec4 s = textureOffset(t, v, ivec2(0, 1));
-    lowp vec4 e = textureOffset(t, v, ivec2(1, 0));
-    lowp vec4 w = textureOffset(t, v, ivec2(-1, 0));
-
-    // Calculate Luma for cheap/fast processing
-    lowp float lC = dot(col.rgb, vec3(0.299, 0.587, 0.114));
-    lowp float lN = dot(n.rgb, vec3(0.299, 0.587, 0.114));
-    lowp float lS = dot(s.rgb, vec3(0.299, 0.587, 0.114));
-    lowp float lE = dot(e.rgb, vec3(0.299, 0.587, 0.114));
-    lowp float lW = dot(w.rgb, vec3(0.299, 0.587, 0.114));
-
-    // Calculate Contrast
-    lowp float mx = max(lC, max(max(lN, lS), max(lE, lW)));
-    lowp float mn = min(lC, min(min(lN, lS), min(lE, lW)));
-    lowp float amt = sqrt(clamp(mn / (1.0 - mx + 0.001), 0.0, 1.0));
-    
-    // Apply Sharpening (Strength 0.88)
-    lowp float peak = -1.0 / mix(8.0, 5.0, amt * 0.88); 
-    lowp float sharpLuma = lC + (lN + lS + lE + lW) * peak;
-    sharpLuma /= (1.0 + 4.0 * peak);
-    
-    // Apply Luma delta to Color
-    col.rgb += (sharpLuma - lC);
-
-    // 2. VIBRANCE (Color Restoration)
-    // Boosts muted colors slightly to counter blur washout
-    lowp float maxRGB = max(col.r, max(col.g, col.b));
-    lowp float minRGB = min(col.r, min(col.g, col.b));
-    lowp float sat = maxRGB - minRGB;
-    col.rgb = mix(col.rgb, vec3(maxRGB), (1.0 - pow(sat, 0.5)) * -0.2);
-
-    // 3. ACES TONEMAP
-    lowp vec3 x = col.rgb;
-    col.rgb = clamp((x*(2.51*x+0.03))/(x*(2.43*x+0.59)+0.14), 0.0, 1.0);
-
-    // 4. ALPHA SAFETY (Fixes UI Bugs)
-    o = vec4(col.rgb, 1.0);
-})";
+// =============================================================
+// 5. SCENE CAPTURE (Pre-HUD)
+// =============================================================
+// The HUD is drawn last, into the default framebuffer, blended and without depth
+// testing. The first such draw after a depth-tested one marks the end of the world:
+// the effect runs right there and the HUD lands on top of it, unblurred. With the
+// redirect active, the HUD then goes to the real surface at full resolution.
+static bool depthOn=false, blendOn=false, scissorOn=false, worldSeen=false, sceneDone=false;
+
+void (*oEnable)(GLenum)=0;
+void (*oDisable)(GLenum)=0;
+void (*oDrawArrays)(GLenum,GLint,GLsizei)=0;
+void (*oDrawElements)(GLenum,GLsizei,GLenum,const void*)=0;
+void (*oDrawArraysInstanced)(GLenum,GLint,GLsizei,GLsizei)=0;
+void (*oDrawElementsInstanced)(GLenum,GLsizei,GLenum,const void*,GLsizei)=0;
+
+static void cap(GLenum c, bool on){
+    if(c==GL_DEPTH_TEST) depthOn=on; else if(c==GL_BLEND) blendOn=on; else if(c==GL_SCISSOR_TEST) scissorOn=on;
+}
+void hEnable(GLenum c){ if(!inHook) cap(c,true); oEnable(c); }
+void hDisable(GLenum c){ if(!inHook) cap(c,false); oDisable(c); }
+
+static void sceneCheck(){
+    if(inHook || sceneDone || !sW) return;
+    if(depthOn){ worldSeen=true; return; }
+    if(drawBound || !blendOn || !worldSeen) return;
+
+    // Mid-frame: the game goes on drawing with whatever it had bound and set, so
+    // everything render() or a rebuild in initGL()/buildMesh() touches goes back
+    GLState st;
+    inHook=true; st.save(); render(sW,sH,false); st.restore(); inHook=false;
+    sceneDone=true; uiPhase=gameFBO!=0; redirectRebind();
+}
+
+void hDrawArrays(GLenum m, GLint f, GLsizei c){ sceneCheck(); oDrawArrays(m,f,c); }
+void hDrawElements(GLenum m, GLsizei c, GLenum t, const void* i){ sceneCheck(); oDrawElements(m,c,t,i); }
+void hDrawArraysInstanced(GLenum m, GLint f, GLsizei c, GLsizei n){ sceneCheck(); oDrawArraysInstanced(m,f,c,n); }
+void hDrawElementsInstanced(GLenum m, GLsizei c, GLenum t, const void* i, GLsizei n){ sceneCheck(); oDrawElementsInstanced(m,c,t,i,n); }
 
 // =============================================================
-// 3. RENDER ENGINE
+// 6. SURFACE PRE-ROTATION
 // =============================================================
-static GLuint rawTex=0, rawFBO=0, histTex[2]={0,0}, histFBO[2]={0,0}, vao=0;
-static GLuint progBlur=0, progDraw=0;
-static int ping=0, iW=0, iH=0, sW=0, sH=0;
-
-void initGL(int w, int h) {
-    // Resource cleanup
-    if(rawTex){glDeleteTextures(1,&rawTex); glDeleteFramebuffers(1,&rawFBO); glDeleteTextures(2,histTex); glDeleteFramebuffers(2,histFBO); glDeleteVertexArrays(1,&vao);}
-    
-    // Internal Resolution
-    iW=(int)(w*SCALE); iH=(int)(h*SCALE);
-
-    // Shader Compilation
-    auto c=[](GLenum t, const char* s){GLuint x=glCreateShader(t); glShaderSource(x,1,&s,0); glCompileShader(x); return x;};
-    GLuint vs=c(GL_VERTEX_SHADER,vert), fs1=c(GL_FRAGMENT_SHADER,frag_blur), fs2=c(GL_FRAGMENT_SHADER,frag_draw);
-    
-    progBlur=glCreateProgram(); glAttachShader(progBlur,vs); glAttachShader(progBlur,fs1); glLinkProgram(progBlur);
-    glUseProgram(progBlur); glUniform1i(glGetUniformLocation(progBlur,"c"),0); glUniform1i(glGetUniformLocation(progBlur,"h"),1);
-
-    progDraw=glCreateProgram(); glAttachShader(progDraw,vs); glAttachShader(progDraw,fs2); glLinkProgram(progDraw);
-    
-    // Geometry Setup
-    GLfloat d[]={-1,1,0,1, -1,-1,0,0, 1,-1,1,0, 1,1,1,1}; GLushort i[]={0,1,2, 0,2,3};
-    glGenVertexArrays(1,&vao); glBindVertexArray(vao);
-    GLuint vb,ib; glGenBuffers(1,&vb); glBindBuffer(GL_ARRAY_BUFFER,vb); glBufferData(GL_ARRAY_BUFFER,sizeof(d),d,GL_STATIC_DRAW);
-    glGenBuffers(1,&ib); glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,ib); glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(i),i,GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0); glVertexAttribPointer(0,2,GL_FLOAT,0,16,0); glEnableVertexAttribArray(1); glVertexAttribPointer(1,2,GL_FLOAT,0,16,(void*)8);
-
-    // Texture Setup
-    auto t = [&](GLuint& tx, GLuint& fb){
-        glGenTextures(1,&tx); glBindTexture(GL_TEXTURE_2D,tx);
-        glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,iW,iH,0,GL_RGBA,GL_UNSIGNED_BYTE,0);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR); glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE); glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
-        glGenFramebuffers(1,&fb); glBindFramebuffer(GL_FRAMEBUFFER,fb); glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,tx,0);
-    };
-    t(rawTex,rawFBO); t(histTex[0],histFBO[0]); t(histTex[1],histFBO[1]);
-    
-    // Clear Buffers
-    glBindFramebuffer(GL_FRAMEBUFFER,histFBO[0]); glClearColor(0,0,0,1); glClear(GL_COLOR_BUFFER_BIT);
-    glBindFramebuffer(GL_FRAMEBUFFER,histFBO[1]); glClearColor(0,0,0,1); glClear(GL_COLOR_BUFFER_BIT);
-    sW=w; sH=h;
-}
-
-void render(int w, int h) {
-    if(w!=sW || h!=sH || !rawTex) initGL(w,h);
-    
-    // Save state is not strictly required for SwapBuffers hooks on Android, 
-    // but disabling tests is crucial for our full-screen pass.
-    glDisable(GL_SCISSOR_TEST); glDisable(GL_DEPTH_TEST); glDisable(GL_BLEND);
-
-    // 1. FAST COPY (Downscale)
-    glBindFramebuffer(GL_READ_FRAMEBUFFER,0); glBindFramebuffer(GL_DRAW_FRAMEBUFFER,rawFBO);
-    glBlitFramebuffer(0,0,w,h,0,0,iW,iH,GL_COLOR_BUFFER_BIT,GL_LINEAR);
-
-    // 2. BLUR PASS
-    int cur=ping, pre=1-ping;
-    glBindFramebuffer(GL_FRAMEBUFFER,histFBO[cur]); glViewport(0,0,iW,iH); glBindVertexArray(vao);
-    glUseProgram(progBlur);
-    glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D,rawTex);
-    glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_2D,histTex[pre]);
-    glDrawElements(GL_TRIANGLES,6,GL_UNSIGNED_SHORT,0);
-
-    // 3. DRAW PASS (Upscale + Sharpen)
-    glBindFramebuffer(GL_FRAMEBUFFER,0); glViewport(0,0,w,h);
-    glUseProgram(progDraw);
-    glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D,histTex[cur]);
-    glDrawElements(GL_TRIANGLES,6,GL_UNSIGNED_SHORT,0);
-
-    ping=pre;
+// When the display is rotated, the compositor normally spends a full-screen pass
+// rotating our buffer. With the game redirected we own every output pixel, so we
+// can rotate in our draw pass instead: the buffer takes the panel's orientation,
+// the window is told its content is pre-transformed, and the game keeps seeing
+// its own orientation through eglQuerySurface. Masks, mesh and HUD mask all live
+// in the game's orientation and need no change.
+// HUD drawn after a scene capture goes straight to the surface, so no pre-rotation then.
+#define TRANSFORM_HINT 8   // NATIVE_WINDOW_TRANSFORM_HINT (system/window.h)
+enum { XF_ROT_90=4, XF_ROT_180=3, XF_ROT_270=7 };
+static int (*winQuery)(const ANativeWindow*,int,int*)=0;
+static int32_t (*winSetTransform)(ANativeWindow*,int32_t)=0;
+static struct { EGLSurface s; ANativeWindow* win; } windows[4];
+static int windowNext=0;
+static EGLSurface rotSurf=0;   // the surface currently pre-rotated (by `turns`)
+static EGLint logW=0, logH=0;  // its size in the game's orientation
+
+EGLBoolean (*oQuerySurface)(EGLDisplay,EGLSurface,EGLint,EGLint*)=0;
+EGLSurface (*oCreateWindowSurface)(EGLDisplay,EGLConfig,EGLNativeWindowType,const EGLint*)=0;
+
+EGLSurface hCreateWindowSurface(EGLDisplay d, EGLConfig c, EGLNativeWindowType w, const EGLint* a){
+    EGLSurface s=oCreateWindowSurface(d,c,w,a);
+    if(s!=EGL_NO_SURFACE){ windows[windowNext%4].s=s; windows[windowNext%4].win=(ANativeWindow*)w; windowNext++; }
+    return s;
+}
+
+// The game asks for its own orientation
+EGLBoolean hQuerySurface(EGLDisplay d, EGLSurface s, EGLint a, EGLint* v){
+    if(s==rotSurf && (turns&1) && (a==EGL_WIDTH || a==EGL_HEIGHT)) a= a==EGL_WIDTH?EGL_HEIGHT:EGL_WIDTH;
+    return oQuerySurface(d,s,a,v);
+}
+
+// Pre-rotation needs the surface's window, its transform hint and the size hook. The
+// window hook goes in from the constructor: games create their surface during startup,
+// before mainthread wakes. There is no public way back from a surface to its window,
+// so a surface created earlier still (the mod loaded late) just stays unrotated.
+// ANativeWindow_query is not NDK API: libnativewindow exports it for vendor code since
+// Android 10. Without it (or with a hint it doesn't document) the compositor rotates.
+static void trackWindows(){
+    if(GAME_SCALE>=1.0f || SCENE_CAPTURE) return;
+    int api=android_get_device_api_level();
+    void* nw=api>=26?dlopen("libnativewindow.so",RTLD_NOW):0;
+    winSetTransform=nw?(int32_t(*)(ANativeWindow*,int32_t))dlsym(nw,"ANativeWindow_setBuffersTransform"):0;
+    winQuery=nw && api>=29?(int(*)(const ANativeWindow*,int,int*))dlsym(nw,"ANativeWindow_query"):0;
+    GHandle h=GlossOpen("libEGL.so");
+    void* cw=(void*)GlossSymbol(h,"eglCreateWindowSurface",0), *qs=(void*)GlossSymbol(h,"eglQuerySurface",0);
+    if(winQuery && winSetTransform && cw && qs){ GlossHook(cw,(void*)hCreateWindowSurface,(void**)&oCreateWindowSurface); GlossHook(qs,(void*)hQuerySurface,(void**)&oQuerySurface); }
+    else { winQuery=0; LOG("pre-rotation: off (no transform hint on Android API %d)",api); }
+}
+
+static void physicalSize(EGLDisplay d, EGLSurface s, EGLint* w, EGLint* h){
+    auto q=oQuerySurface?oQuerySurface:eglQuerySurface;
+    q(d,s,EGL_WIDTH,w); q(d,s,EGL_HEIGHT,h);
+}
+
+// Polled every 30 frames; takes effect from the next dequeued buffer
+static void updateRotation(EGLSurface s, EGLint pw, EGLint ph){
+    if(!redirect || SCENE_CAPTURE || !winQuery || !winSetTransform || frame%30) return;
+    ANativeWindow* win=0;
+    for(auto& e:windows) if(e.s==s) win=e.win;
+    static EGLSurface unknown=0;
+    if(!win){ if(s!=unknown) logLater("pre-rotation: surface created before the hook, not rotated"); unknown=s; return; }
+    int hint=0; if(winQuery(win,TRANSFORM_HINT,&hint)!=0) return;
+    if(hint<0 || hint>7){ winQuery=0; logLater("pre-rotation: off (transform hint %d)",hint); return; }
+    int t = hint==XF_ROT_90?1 : hint==XF_ROT_180?2 : hint==XF_ROT_270?3 : 0;
+    if(s==rotSurf && t==turns) return;
+    bool swapped=s==rotSurf && (turns&1) && pw==logH && ph==logW;
+    logW=swapped?ph:pw; logH=swapped?pw:ph;
+    static const int inverse[4]={0,XF_ROT_270,XF_ROT_180,XF_ROT_90};
+    winSetTransform(win,inverse[t]);
+    ANativeWindow_setBuffersGeometry(win,(t&1)?logH:logW,(t&1)?logW:logH,0);
+    rotSurf=s; turns=t;
+    logLater("pre-rotation: %d degrees",t*90);
 }
 
 // =============================================================
-// 4. HOOKS
+// 7. HOOKS
 // =============================================================
 EGLBoolean (*orig)(EGLDisplay,EGLSurface)=0;
+EGLBoolean (*origDamage)(EGLDisplay,EGLSurface,const EGLint*,EGLint)=0;
+EGLBoolean (*origSetDamage)(EGLDisplay,EGLSurface,const EGLint*,EGLint)=0;
+static bool swapping=false;      // libEGL may implement one swap entry point with the other
+static Rect region={0,0,0,0};    // eglSetDamageRegionKHR of the current frame
+static int regionAge=0;          // EGL_BUFFER_AGE_EXT of that frame's buffer (0: set to the whole buffer)
+
+// Sample count, colour format and stencil bits of a surface, from its EGL config.
+// Cached per surface.
+static SurfaceInfo surfaceInfo(EGLDisplay d, EGLSurface s){
+    static SurfaceInfo cache[4]; static int next=0;
+    for(const SurfaceInfo& c:cache) if(c.s==s) return c;
+    SurfaceInfo r={s,0,GL_RGBA8,0};
+    EGLint id=0, n=0, a[]={EGL_CONFIG_ID,0,EGL_NONE}; EGLConfig cf;
+    eglQuerySurface(d,s,EGL_CONFIG_ID,&id); a[1]=id;
+    if(eglChooseConfig(d,a,&cf,1,&n) && n==1){
+        EGLint samples=0,rs=8,gs=8,bs=8,as=8,st=0;
+        eglGetConfigAttrib(d,cf,EGL_SAMPLES,&samples); eglGetConfigAttrib(d,cf,EGL_RED_SIZE,&rs);
+        eglGetConfigAttrib(d,cf,EGL_GREEN_SIZE,&gs); eglGetConfigAttrib(d,cf,EGL_BLUE_SIZE,&bs); eglGetConfigAttrib(d,cf,EGL_ALPHA_SIZE,&as);
+        eglGetConfigAttrib(d,cf,EGL_STENCIL_SIZE,&st);   // a GL query on a stencil-less default framebuffer is an error
+        r.samples=samples; r.stencil=st;
+        r.fmt = rs==5&&gs==6&&bs==5 ? GL_RGB565 : rs==10 ? GL_RGB10_A2 : as==0 ? GL_RGB8 : GL_RGBA8;
+    }
+    return cache[next++%4]=r;
+}
+
+// Frame pacing: swap-to-swap interval and our own CPU time per present, in
+// one-second windows rotated by mainthread, which logs percentiles over all of them
+static const int PACE_WINDOWS = 10;
+static_assert(BENCH_MAX<PACE_WINDOWS,"bench reads whole windows");
+static RollingHistogram<PACE_WINDOWS> swapTimes, hookTimes;
+static uint64_t lastSwap=0;
+
+// Shared-memory stats (Stats.h), published once per present
+static StatsFile statsLocal, *statsFile=&statsLocal;   // statsLocal until STATS_PATH is mapped
+static uint64_t presented=0, skipped=0;
+static float fps=0;
+static Seqlock<GovernorSample> govSample;   // last governor reading, see section 9
+
+static void statsOpen(){
+    int fd=open(STATS_PATH,O_RDWR|O_CREAT,0644);
+    if(fd<0) return;
+    void* p=ftruncate(fd,sizeof(StatsFile))==0 ? mmap(0,sizeof(StatsFile),PROT_READ|PROT_WRITE,MAP_SHARED,fd,0) : MAP_FAILED;
+    close(fd);
+    if(p==MAP_FAILED) return;
+    StatsFile* f=new(p) StatsFile{};
+    f->version=STATS_VERSION; f->size=sizeof(StatsFile); memcpy(f->magic,"MBST",4);
+    statsFile=f;
+}
+
+static void statsPublish(int w, int h){
+    Stats st{};
+    st.frames=presented; st.skipped=skipped; st.updated=lastSwap; st.textureBytes=texBytes; st.fps=fps;
+    for(int p=0;p<PASS_COUNT;p++) st.passMs[p]=(float)gpuLast[p];
+    st.scale=cfg.scale; st.gameScale=redirect?gameScale:1.0f;
+    st.width=w; st.height=h; st.levels=levels; st.ring=slots; st.turns=turns;
+    st.flags=(redirect?STATS_REDIRECT:0)|(cfg.checkerboard?STATS_CHECKERBOARD:0)|(UI_MASK?STATS_UI_MASK:0)|(tracing.load(std::memory_order_relaxed)?STATS_TRACING:0);
+    strcpy(st.capture,capture==CAP_BLIT?"blit":capture==CAP_RESOLVE?"resolve":"resolve+downscale");
+    GovernorSample g=govSample.load(); st.governor=governorLevel.load(std::memory_order_relaxed); st.temp=g.temp; st.battery=g.battery;
+    statsFile->stats.store(st);
+}
+
+static void logPacing(){
+    HistSnapshot a=swapTimes.snapshot(), b=hookTimes.snapshot();
+    if(!a.count) return;
+    auto ms=[](const HistSnapshot& x, double q){ return x.percentile(q)*1e-6; };
+    LOG("swap p50 %.2f p90 %.2f p99 %.2f p99.9 %.2f max %.2f ms | hook p50 %.3f p99 %.3f max %.3f ms | %llu frames",
+        ms(a,0.5),ms(a,0.9),ms(a,0.99),ms(a,0.999),a.max*1e-6, ms(b,0.5),ms(b,0.99),b.max*1e-6, (unsigned long long)a.count);
+    HistSnapshot g=latency.gpuDone.snapshot(), p=latency.display.snapshot(), x=latency.extra.snapshot();
+    if(p.count) LOG("latency from swap: gpu done p50 %.2f p99 %.2f | on screen p50 %.2f p99 %.2f | added by us p50 %.2f p99 %.2f ms",
+        ms(g,0.5),ms(g,0.99), ms(p,0.5),ms(p,0.99), ms(x,0.5),ms(x,0.99));
+}
+
+// Fenced readback into pixel-pack buffers, shared by recording and the frame
+// dump. issue() reads the bound read framebuffer into the next buffer and
+// fences it; later frames retire() whatever the GPU has finished, in order,
+// mapped, to a callback that passes the pointer to the recorder queue
+// (Recorder.cpp), and release() unmaps it once the worker is done. Nothing
+// here waits: with every buffer busy the frame is dropped. The game's own
+// pixel-pack buffer binding is put back after each of them.
+enum { SLOT_IDLE, SLOT_READING, SLOT_ENCODING };
+struct PackBinding {
+    GLint b=0;
+    PackBinding(){ glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING,&b); }
+    ~PackBinding(){ glBindBuffer(GL_PIXEL_PACK_BUFFER,b); }
+};
+template<int N> struct Readback {
+    struct Slot { GLuint pbo; GLsync fence; int w, h, size, state; std::atomic<bool> done; };
+    Slot s[N];
+    unsigned issued=0, retired=0, dropped=0;
+
+    bool idle() const { return issued==retired; }
+    // Also every handed-off buffer back from the worker
+    bool drained() const {
+        if(!idle()) return false;
+        for(const Slot& x:s) if(x.state!=SLOT_IDLE) return false;
+        return true;
+    }
+    bool ready() const { return s[issued%N].state==SLOT_IDLE; }
+    void release(){
+        PackBinding keep;
+        for(Slot& x:s) if(x.state==SLOT_ENCODING && x.done.load(std::memory_order_acquire)){
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,x.pbo); glUnmapBuffer(GL_PIXEL_PACK_BUFFER); x.state=SLOT_IDLE;
+        }
+    }
+    // hand(slot, pixels, index) returns false when the worker can't take it
+    template<class F> void retire(F hand){
+        PackBinding keep;
+        for(;retired!=issued;retired++){
+            Slot& x=s[retired%N];
+            GLenum st=glClientWaitSync(x.fence,0,0);
+            if(st!=GL_ALREADY_SIGNALED && st!=GL_CONDITION_SATISFIED) break;
+            glDeleteSync(x.fence); x.fence=0;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,x.pbo);
+            void* p=glMapBufferRange(GL_PIXEL_PACK_BUFFER,0,x.size,GL_MAP_READ_BIT);
+            x.done.store(false,std::memory_order_relaxed);
+            if(p && hand(x,(const uint8_t*)p,(int)(retired%N))) x.state=SLOT_ENCODING;
+            else { if(p) glUnmapBuffer(GL_PIXEL_PACK_BUFFER); x.state=SLOT_IDLE; dropped++; }
+        }
+    }
+    // Slot index, or -1 when the encoder or disk is behind
+    int issue(int w, int h){
+        Slot& x=s[issued%N];
+        if(x.state!=SLOT_IDLE){ dropped++; return -1; }
+        PackBinding keep;
+        if(!x.pbo) glGenBuffers(1,&x.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,x.pbo);
+        if(x.size!=w*h*4){ x.size=w*h*4; glBufferData(GL_PIXEL_PACK_BUFFER,x.size,0,GL_STREAM_READ); }
+        glReadPixels(0,0,w,h,GL_RGBA,GL_UNSIGNED_BYTE,0);
+        x.fence=glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0); x.w=w; x.h=h; x.state=SLOT_READING;
+        return (int)(issued++%N);
+    }
+};
+
+// Recording: the finished buffer, REC_SLOTS readbacks deep
+static const int REC_SLOTS = 6;
+struct RecRequest { int kind, frames; };   // frames: 1 = screenshot, -1 = until stopped, 0 = stop
+static Seqlock<RecRequest> recRequest;     // written by the control socket
+static Readback<REC_SLOTS> rec;
+static unsigned recSeen=0;
+static int recLeft=0, recKind=REC_PNG;
+static bool recOpen=false;
+
+static void recordFrame(int w, int h){
+    recordKick();
+    // A request of the other kind waits until the current recording has closed
+    if(unsigned v=recRequest.version(); v!=recSeen){
+        RecRequest q=recRequest.load();
+        if(!recOpen || !q.frames || q.kind==recKind){ recSeen=v; recLeft=q.frames; recKind=q.kind; }
+    }
+    if(!recOpen && !recLeft) return;
+    rec.release();
+    rec.retire([](auto& s, const uint8_t* p, int){ return recordPush({RecordJob::FRAME,0,s.w,s.h,0,p,&s.done}); });
+    if(!recLeft){
+        if(rec.idle() && recordPush({RecordJob::CLOSE})){ recOpen=false; if(rec.dropped) logLater("recording: %u frames dropped",rec.dropped); }
+        return;
+    }
+    // A new recording starts once the previous one has drained
+    if(!recOpen){
+        if(!rec.idle() || !recordPush({RecordJob::OPEN,recKind,w,h,fps>1?(int)(fps+0.5f):60})) return;
+        recOpen=true; rec.dropped=0;
+    }
+    if(recLeft>0) recLeft--;
+    bindReadable(w,h);
+    rec.issue(w,h);
+    glBindFramebuffer(GL_FRAMEBUFFER,0);
+}
+
+// Frame dump (dump_seconds > 0): every processed frame's capture, scaled to
+// DUMP_SIZE on its longer side, goes through its own readback into the ring
+// file at DUMP_PATH (FrameDump.h); the recorder queue does the copy. The ring
+// is mapped, so after a crash it is still there for mbreplay, with the surface
+// and settings in its header (refreshed once a second). The kernel writes it
+// back in the background, about 15 MB/s while dump_seconds is on. Mapping,
+// resizing and saving the ring are worker tasks (Workers.h) collected here
+// each frame, so the render thread never touches the file system. They are
+// only posted once every copy has landed, and while one is out the ring is
+// left alone, which is what freezes it for 'dump'.
+static const int DUMP_SIZE = 256, DUMP_RATE = 60;   // ring slots per second of dump_seconds
+static const char* const REPLAY_KEYS[] = {"mask","mask_inner","mask_outer","ring","checkerboard","fovea_levels","fovea_size","scale","sharpen"};   // what shapes the output
+static Readback<3> dumpRb;
+static DumpFrame dumpTag[3];
+static GLuint dumpTex=0, dumpFBO=0;
+static DumpHeader* ring=0;                          // ours while no task has it
+static std::atomic<unsigned> dumpRequests{0};       // bumped by the control socket
+static unsigned dumpSeen=0;
+static int ringSlots=0;
+struct RingRemap { DumpHeader* old; int slots; };
+
+// The first mapping in a process keeps the previous session's ring (a crash's
+// last seconds) as DUMP_PATH.prev
+static DumpHeader* remapRing(const RingRemap& r){
+    static bool kept=false;
+    if(!kept){ char prev[256]; snprintf(prev,sizeof(prev),"%s.prev",DUMP_PATH); rename(DUMP_PATH,prev); kept=true; }
+    dumpClose(r.old);
+    DumpHeader* h=r.slots?dumpOpen(DUMP_PATH,r.slots,DUMP_SIZE):0;
+    if(r.slots && !h) LOG("frame dump: can't map %s",DUMP_PATH);
+    return h;
+}
+
+static bool saveRing(DumpHeader* const& h){
+    char path[256];
+    bool ok=dumpSave(h,RECORD_DIR,path,sizeof(path));
+    if(ok) LOG("frame dump: %u frames to %s",h->written<h->slots?h->written:h->slots,path);
+    else LOG("frame dump: nothing saved");
+    return ok;
+}
+
+static WorkTask<RingRemap,DumpHeader*> ringRemap(remapRing);
+static WorkTask<DumpHeader*,bool> ringSave(saveRing);
+
+// What mbreplay needs to process the frames as this device did
+static void describeRing(){
+    ring->samples=surf.samples; ring->fmt=surf.fmt; ring->redirect=redirect; ring->gameScale=gameScale;
+    char o[sizeof(ring->config)]=""; size_t n=sizeof(o);
+    for(const char* k:REPLAY_KEYS){ char v[64]; getKey(cfg,k,v,sizeof(v)); size_t l=strlen(o); snprintf(o+l,n-l,"%s%s=%s",l?" ":"",k,v); }
+    memcpy(ring->config,o,n);
+}
+
+static void dumpTap(const CaptureInfo& c){
+    dumpRb.release();
+    if(DumpHeader* const* h=ringRemap.poll()) if((ring=*h)) describeRing();
+    ringSave.poll();
+    if(ringRemap.busy() || ringSave.busy()) return;
+    dumpRb.retire([](auto& s, const uint8_t* p, int i){
+        if(!ring) return false;
+        DumpFrame* f=dumpSlot(ring,ring->written);
+        RecordJob j={RecordJob::COPY,0,0,0,0,p,&s.done,dumpPixels(f),(size_t)s.size};
+        if(!recordPush(j)) return false;
+        *f=dumpTag[i]; ring->written++;   // the worker reads neither until a later task
+        return true;
+    });
+    // Remap once what is in flight has landed in the old ring
+    int want=cfg.dumpSeconds*DUMP_RATE;
+    if(want!=ringSlots){
+        if(dumpRb.drained() && ringRemap.post({ring,want})){ ring=0; ringSlots=want; }
+        return;
+    }
+    if(unsigned r=dumpRequests.load(std::memory_order_relaxed); r!=dumpSeen){
+        if(!ring){ dumpSeen=r; return; }
+        if(!dumpRb.drained()) return;   // stop issuing until the ring has everything
+        describeRing();
+        if(ringSave.post(ring)) dumpSeen=r;
+        return;
+    }
+    if(!ring) return;
+    if(frame%DUMP_RATE==0) describeRing();
+    if(!dumpRb.ready()) return;
+    int pw=c.w>=c.h?DUMP_SIZE:(c.w*DUMP_SIZE+c.h/2)/c.h, ph=c.w>=c.h?(c.h*DUMP_SIZE+c.w/2)/c.w:DUMP_SIZE;
+    if(!dumpTex){
+        glActiveTexture(GL_TEXTURE0);
+        glGenTextures(1,&dumpTex); glBindTexture(GL_TEXTURE_2D,dumpTex); glTexStorage2D(GL_TEXTURE_2D,1,GL_RGBA8,DUMP_SIZE,DUMP_SIZE);
+        glGenFramebuffers(1,&dumpFBO); glBindFramebuffer(GL_FRAMEBUFFER,dumpFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,dumpTex,0);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,c.fbo); glBindFramebuffer(GL_DRAW_FRAMEBUFFER,dumpFBO);
+    glBlitFramebuffer(0,0,c.fw,c.fh,0,0,pw,ph,GL_COLOR_BUFFER_BIT,GL_LINEAR);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,dumpFBO);
+    int i=dumpRb.issue(pw,ph);
+    if(i>=0) dumpTag[i]={traceNow(),frame,c.w,c.h,pw,ph,{c.damage.x0,c.damage.y0,c.damage.x1,c.damage.y1},(uint8_t)c.mask,(uint8_t)turns};
+}
+
+// Our passes as one effect of the present chain (PresentChain.h): run by
+// present() while we host it, by the other mod's swap hook once we joined theirs
+static bool joined=false;
+static int chainRan=0;   // effects in the last run; more than us means the whole buffer changes
+
+static void chainEffect(const PresentTarget* t, void*){
+    int w=t->width, h=t->height;
+    if(sceneDone){   // processed under the HUD already: pass the frame on
+        if(t->output_fbo!=t->input_fbo){
+            glBindFramebuffer(GL_READ_FRAMEBUFFER,t->input_fbo); glBindFramebuffer(GL_DRAW_FRAMEBUFFER,t->output_fbo);
+            glBlitFramebuffer(0,0,w,h,0,0,w,h,GL_COLOR_BUFFER_BIT,GL_NEAREST);
+        }
+        return;
+    }
+    if(joined && t->surface!=surf.s) surf=surfaceInfo((EGLDisplay)t->display,(EGLSurface)t->surface);
+    Rect D; if(t->damage) D={t->damage[0],t->damage[1],t->damage[2],t->damage[3]};
+    bool was=inHook;
+    inputFBO=t->input_fbo; outputFBO=t->output_fbo;
+    inHook=true; render(w,h,true,t->damage?&D:0); inHook=was;
+    inputFBO=outputFBO=0;
+    depthOn=blendOn=scissorOn=false;
+    if(joined){ presented++; statsPublish(w,h); }
+}
+
+static void present(EGLDisplay d, EGLSurface s, const Rect* damage){
+    uint64_t t0=traceNow();
+    if(lastSwap){
+        swapTimes.record(t0-lastSwap); fps+=(1e9f/(float)(t0-lastSwap)-fps)/16;
+        if(abSample()) abSwap.add(variant,abBlock,t0-lastSwap);   // still tagged with the frame it closes
+    }
+    lastSwap=t0;
+    EGLint w,h; physicalSize(d,s,&w,&h);
+    if(s!=surf.s) surf=surfaceInfo(d,s);
+    processed={0,0,w,h};
+    updateRotation(s,w,h);
+    // A buffer still in the old geometry is not turned yet
+    int applied=s==rotSurf?turns:0;
+    if((applied&1) && !(w==logH && h==logW)) applied=0;
+    if(applied&1){ EGLint t=w; w=h; h=t; }
+    if(applied) damage=0;
+    // Partial output only where the buffer provably holds our previous output
+    EGLint behavior=EGL_BUFFER_DESTROYED; eglQuerySurface(d,s,EGL_SWAP_BEHAVIOR,&behavior);
+    bufferAge=applied ? 0 : !region.empty() ? regionAge : behavior==EGL_BUFFER_PRESERVED ? 1 : 0;
+    int keep=turns; turns=applied;
+    if(w>100){
+        int dm[4]; if(damage){ dm[0]=damage->x0; dm[1]=damage->y0; dm[2]=damage->x1; dm[3]=damage->y1; }
+        inHook=true; chainRan=presentChainLocal()->run(d,s,w,h,damage?dm:0); inHook=false;
+        if(chainRan>1) processed={0,0,w,h};   // the other effects rewrite the whole buffer
+    }
+    else if(!sceneDone){ skipped++; trace(EV_SKIP,0,w); }
+    if(w>100){ inHook=true; recordFrame(applied&1?h:w,applied&1?w:h); inHook=false; }   // the buffer as it will be shown
+    presented++;
+    statsPublish(w,h);
+    turns=keep;
+    if(applied&1) processed={0,0,h,w};
+    uint64_t own=traceNow()-t0;
+    hookTimes.record(own);
+    if(abSample()) abHook.add(variant,abBlock,own);
+}
+
+static void finish(){
+    worldSeen=sceneDone=uiPhase=false; region={0,0,0,0}; regionAge=0;
+    // Hand the game back its (redirected) default framebuffer for the next frame
+    if(oBindFramebuffer) redirectRebind();
+}
+
 EGLBoolean hook(EGLDisplay d, EGLSurface s){
-    EGLint w,h; eglQuerySurface(d,s,EGL_WIDTH,&w); eglQuerySurface(d,s,EGL_HEIGHT,&h);
-    if(w>100) render(w,h);
-    return orig(d,s);
+    if(swapping) return orig(d,s);
+    trace(EV_HOOK_BEGIN);
+    present(d,s,region.empty()?0:&region);
+    latency.beforeSwap(d,s,lastSwap,traceNow());
+    swapping=true; EGLBoolean r=orig(d,s); swapping=false;
+    latency.poll(d,s);
+    finish();
+    trace(EV_HOOK_END);
+    return r;
 }
 
-void* mainthread(void*){
-    sleep(1); GlossInit(true);
+// Only the damaged area (plus still-fading trails) is processed and reported
+EGLBoolean hookDamage(EGLDisplay d, EGLSurface s, const EGLint* rects, EGLint n){
+    if(swapping) return origDamage(d,s,rects,n);
+    trace(EV_HOOK_BEGIN);
+    Rect D=n>0?bbox(rects,n):region;
+    present(d,s,D.empty()?0:&D);
+    EGLint e[4]={processed.x0,processed.y0,processed.x1-processed.x0,processed.y1-processed.y0};
+    latency.beforeSwap(d,s,lastSwap,traceNow());
+    swapping=true; EGLBoolean r=origDamage(d,s,e,1); swapping=false;
+    latency.poll(d,s);
+    finish();
+    trace(EV_HOOK_END);
+    return r;
+}
+
+// The game promises to touch only this region; our passes reach further while trails
+// fade, and the draw pass also repairs what we changed since this buffer was last shown
+EGLBoolean hookSetDamage(EGLDisplay d, EGLSurface s, const EGLint* rects, EGLint n){
+    if(n<=0 || (s==rotSurf && turns) || chainRan>1) return origSetDamage(d,s,rects,0);   // pre-rotated or chained: the whole buffer
+    EGLint age=0; eglQuerySurface(d,s,EGL_BUFFER_AGE_EXT,&age);   // already queried by the game, which the extension requires
+    if(age<=0 || age>DECAY_FRAMES) return origSetDamage(d,s,rects,0);   // contents unknown: we redraw everything
+    region=bbox(rects,n); regionAge=age;
+    Rect u=unite(unite(region,decayRegion()),repairRegion(age));
+    EGLint e[4]={u.x0,u.y0,u.x1-u.x0,u.y1-u.y0};
+    return origSetDamage(d,s,e,1);
+}
+
+// =============================================================
+// 8. CONTROL SOCKET
+// =============================================================
+// One client at a time, one command per line, one reply line each ("ok ..." / "err ..."),
+// all parsed in Control.cpp:
+//   get [key]            current value(s)
+//   set key value        same keys as the config file, applied on the next frame
+//   preset name          performance | balanced | quality
+//   bench seconds        reset the pacing histograms, wait, report (up to BENCH_MAX s)
+//   dump-stats           the shared-memory stats as key=value
+//   ab N keys | keys     alternate two sets of keys every N frames (ab off to stop)
+//   ab                   B - A per metric with 95% intervals
+//   screenshot           next output frame to RECORD_DIR as PNG
+//   record [seconds|stop] output frames to RECORD_DIR as Y4M (no seconds: until stop)
+//   dump                 the frame dump ring (dump_seconds) to RECORD_DIR as .mbfd, for tools/mbreplay
+// Settings go through editConfig(), the same seqlock the config file feeds.
+template<class F> static bool editConfig(F edit){
+    pthread_mutex_lock(&configWrite);
+    Config c=config.load(); bool ok=edit(c);
+    if(ok){
+        if(c.maskOuter<c.maskInner) c.maskOuter=c.maskInner;
+        config.store(c);
+        if(c.trace) traceStart(c.trace==2?TRACE_JSON_PATH:TRACE_PATH,passName); else traceStop();
+        if(c.dumpSeconds) recorderInit(RECORD_DIR);   // the ring is filled and saved on the worker pool
+    }
+    pthread_mutex_unlock(&configWrite);
+    return ok;
+}
+
+// What the commands parsed in Control.cpp do here
+static void bench(int fd, int sec){
+    swapTimes.reset(); hookTimes.reset();
+    sleep(sec);
+    HistSnapshot a=swapTimes.snapshot(), b=hookTimes.snapshot();
+    auto ms=[](const HistSnapshot& x, double q){ return x.percentile(q)*1e-6; };
+    Stats st=statsFile->stats.load();
+    dprintf(fd,"ok seconds=%d frames=%llu fps=%.1f swap_p50=%.3f swap_p99=%.3f swap_max=%.3f hook_p50=%.3f hook_p99=%.3f capture=%.3f blur=%.3f draw=%.3f\n",
+        sec,(unsigned long long)a.count,a.count/(double)sec, ms(a,0.5),ms(a,0.99),a.max*1e-6, ms(b,0.5),ms(b,0.99), st.passMs[0],st.passMs[1],st.passMs[2]);
+}
+
+static void abReport(int fd){
+    char out[1024];
+    AbSummary s=abSummary.load(); int n=snprintf(out,sizeof(out),"ok every=%d",s.every);
+    for(int i=0;i<3;i++) if(s.m[i].ok) n+=snprintf(out+n,sizeof(out)-n," %s_a=%.3f %s_b=%.3f %s_diff=%.3f %s_ci=%.3f %s_blocks=%d/%d %s_p50=%.3f/%.3f %s_p99=%.3f/%.3f",
+        abName[i],s.m[i].a,abName[i],s.m[i].b,abName[i],s.m[i].d,abName[i],s.m[i].ci,abName[i],s.m[i].na,s.m[i].nb,
+        abName[i],s.m[i].p50[0],s.m[i].p50[1],abName[i],s.m[i].p99[0],s.m[i].p99[1]);
+    dprintf(fd,"%s\n",out);
+}
+
+static const ControlHandlers handlers={
+    [](const char* k, const char* v){ return editConfig([&](Config& c){ return setKey(c,k,v); }); },
+    bench,
+    [](){ return statsFile->stats.load(); },
+    [](int kind, int frames){ recorderInit(RECORD_DIR); recRequest.store({kind,frames}); },
+    [](){ if(!config.load().dumpSeconds) return false; dumpRequests.fetch_add(1,std::memory_order_relaxed); return true; },
+    abReport,
+};
+
+void* controlthread(void*){
+    int s=controlListen(CONTROL_NAME);
+    if(s<0){ LOG("control socket unavailable"); return 0; }
+    controlServe(s,handlers);
+    return 0;
+}
+
+// =============================================================
+// 9. STARTUP
+// =============================================================
+// Quality governor (Governor.h): sampled once a second by housekeeping() on a worker, its level
+// reaches render() through governorLevel
+static Governor governor;
+
+static void governorTick(){
+    Config c=config.load();
+    GovernorSample g={-1,-1,false};
+    int was=governor.level;
+    if(c.governor){ g=governorRead(c.sysfsRoot); governor.update(g); }
+    else governor=Governor();
+    govSample.store(g);
+    if(governor.level==was) return;
+    governorLevel.store(governor.level,std::memory_order_relaxed);
+    LOG("governor: level %d (%.1f C, battery %d%%%s)%s%s",governor.level,g.temp,g.battery,g.charging?" charging":"",governor.level?": ":"",Governor::STEPS[governor.level]);
+}
+
+// The game's swap entry points, plus the GL ones the redirect and scene capture need
+static void hookGame(){
+    // GL hook groups go in all-or-none (a half redirect corrupts the frame)
+    GHandle g = GlossOpen("libGLESv2.so");
+    auto group=[&](int c, const char** n, void** f, void*** o){
+        void* p[16]; bool all=true;
+        for(int i=0;i<c;i++) all&=(p[i]=(void*)GlossSymbol(g,n[i],0))!=0;
+        if(all) for(int i=0;i<c;i++) GlossHook(p[i],f[i],o[i]);
+        return all;
+    };
+    if(GAME_SCALE<1.0f || SCENE_CAPTURE){
+        const char* n[]={"glBindFramebuffer","glViewport","glScissor","glBlitFramebuffer","glInvalidateFramebuffer","glGetIntegerv","glGetIntegeri_v",
+                         "glReadPixels","glCopyTexImage2D","glCopyTexSubImage2D","glCopyTexSubImage3D"};
+        void* f[]={(void*)hBindFramebuffer,(void*)hViewport,(void*)hScissor,(void*)hBlitFramebuffer,(void*)hInvalidateFramebuffer,(void*)hGetIntegerv,(void*)hGetIntegeri_v,
+                   (void*)hReadPixels,(void*)hCopyTexImage2D,(void*)hCopyTexSubImage2D,(void*)hCopyTexSubImage3D};
+        void** o[]={(void**)&oBindFramebuffer,(void**)&oViewport,(void**)&oScissor,(void**)&oBlitFramebuffer,(void**)&oInvalidateFramebuffer,(void**)&oGetIntegerv,(void**)&oGetIntegeri_v,
+                    (void**)&oReadPixels,(void**)&oCopyTexImage2D,(void**)&oCopyTexSubImage2D,(void**)&oCopyTexSubImage3D};
+        redirect=group(11,n,f,o) && GAME_SCALE<1.0f;
+    }
+    if(SCENE_CAPTURE && oBindFramebuffer){
+        const char* n[]={"glEnable","glDisable","glDrawArrays","glDrawElements","glDrawArraysInstanced","glDrawElementsInstanced"};
+        void* f[]={(void*)hEnable,(void*)hDisable,(void*)hDrawArrays,(void*)hDrawElements,(void*)hDrawArraysInstanced,(void*)hDrawElementsInstanced};
+        void** o[]={(void**)&oEnable,(void**)&oDisable,(void**)&oDrawArrays,(void**)&oDrawElements,(void**)&oDrawArraysInstanced,(void**)&oDrawElementsInstanced};
+        group(6,n,f,o);
+    }
+
+    // Frame timestamps are set up before the swap hook uses them
+    latency.api={(PFNEGLGETFRAMETIMESTAMPSUPPORTEDANDROIDPROC)eglGetProcAddress("eglGetFrameTimestampSupportedANDROID"),
+                 (PFNEGLGETNEXTFRAMEIDANDROIDPROC)eglGetProcAddress("eglGetNextFrameIdANDROID"),
+                 (PFNEGLGETFRAMETIMESTAMPSANDROIDPROC)eglGetProcAddress("eglGetFrameTimestampsANDROID"), eglSurfaceAttrib};
+
+    // Swap hook last, so the first initGL() already knows whether to redirect
     GHandle h = GlossOpen("libEGL.so");
     void* s = (void*)GlossSymbol(h,"eglSwapBuffers",0);
     if(s) GlossHook(s, (void*)hook, (void**)&orig);
+    auto ext=[&](const char* n){ void* p=(void*)GlossSymbol(h,n,0); return p?p:(void*)eglGetProcAddress(n); };
+    if(void* p=ext("eglSwapBuffersWithDamageKHR")) GlossHook(p, (void*)hookDamage, (void**)&origDamage);
+    if(void* p=ext("eglSetDamageRegionKHR")) GlossHook(p, (void*)hookSetDamage, (void**)&origSetDamage);
+
+}
+
+// A game that presents with Vulkan never reaches eglSwapBuffers: the layer's passes
+// go into libvulkan instead (VulkanLayer.h). From the constructor, like the window
+// hook, so the game's instance isn't created before the patch.
+static GHandle vk;
+static void hookVulkan(){
+#ifdef VULKAN_IN_PROCESS
+    if(!(vk=GlossOpen("libvulkan.so"))) return;
+    if(!vulkanHook([](const char* n){ return (void*)GlossSymbol(vk,n,0); },[](void* at, void* repl, void** o){ GlossHook(at,repl,o); }))
+        LOG("vulkan: libvulkan exports missing, Vulkan games stay untouched");
+#endif
+}
+
+// Governor probe and config file reload; returns the file time now seen
+static time_t housekeeping(const time_t& seen){
+    governorTick();
+    struct stat st;
+    if(stat(CONFIG_PATH,&st)!=0 || st.st_mtime==seen) return seen;
+    Config f;
+    if(loadConfig(CONFIG_PATH,f)) editConfig([&](Config& c){ c=f; return true; });
+    return st.st_mtime;
+}
+static WorkTask<time_t,time_t> chores(housekeeping);
+
+void* mainthread(void*){
+    sleep(1);
+    // Present chain first: if another mod already hosts one, our passes run from
+    // its swap hook and none of our GL or EGL hooks go in. Hosting, the redirect
+    // and pre-rotation only work on the game's own frame, so we run first then.
+    PresentChain* host=PRESENT_CHAIN?presentChainFind():0;
+    joined=host && host!=presentChainLocal();
+    PresentEffect fx={sizeof(PresentEffect),"motionblur",PRESENT_ORDER,PRESENT_READS_SURFACE,chainEffect,0};
+    if(!joined && (GAME_SCALE<1.0f || SCENE_CAPTURE)) fx.order=INT_MIN;
+    if(!joined) fx.flags|=PRESENT_KEEPS_STATE;   // the game binds everything it draws with each frame
+    // The stats file, the dump tap and the log writer are set up before the first frame uses them
+    statsOpen(); traceWriterStart();
+    captureTap=dumpTap;
+    if(joined){ presentChainEnable(false); host->add(&fx); }
+    else { presentChainLocal()->add(&fx); hookGame(); }
+
+    // Everything but the render thread lives on the little cores; the control
+    // thread inherits this
+    workersStart(); workPinLittle();
+    pthread_t ct; if(pthread_create(&ct,0,controlthread,0)==0) pthread_detach(ct);
+
+    // Keeps time: turns the pacing windows over once a second and hands the
+    // config watcher and the governor to a worker (a second it is still busy
+    // with is skipped). render() picks up a new snapshot at its next frame.
+    time_t seen=0;
+    for(int tick=1;;sleep(1),tick++){
+        if(tick%PACE_WINDOWS==0) logPacing();
+        swapTimes.rotate(); hookTimes.rotate(); latency.rotate();
+        if(const time_t* t=chores.poll()) seen=*t;
+        chores.post(seen,WORK_IDLE);
+    }
     return 0;
 }
 
-__attribute__((constructor)) void init(){pthread_t t;pthread_create(&t,0,mainthread,0);}
+// Answer present_chain_v1 right away, so mods that look before our thread wakes still find us
+// and the game's first window surface is seen
+__attribute__((constructor)) void init(){presentChainEnable(PRESENT_CHAIN);GlossInit(true);trackWindows();hookVulkan();pthread_t t;pthread_create(&t,0,mainthread,0);}
@@ -0,0 +1,51 @@
+#version 450
+// Vulkan port of frag_draw (Pipeline.cpp) without checkerboard reconstruction
+layout(location = 0) in vec2 v;
+layout(set = 0, binding = 0) uniform sampler2D t;   // History at internal resolution (bilinear upscale)
+layout(push_constant) uniform P {
+    float a;    // Sharpen Strength (0 = no CAS)
+    int srgb;   // sRGB swapchain: the attachment encodes, so hand it linear values
+} p;
+layout(location = 0) out vec4 o;
+
+vec3 decode(vec3 c) { return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), step(0.04045, c)); }
+
+void main() {
+    vec4 col = texture(t, v);
+
+    // 1. CAS SHARPENING (Contrast Adaptive Sharpening)
+    if (p.a > 0.0) {
+        vec4 n = textureOffset(t, v, ivec2(0, -1));
+        vec4 s = textureOffset(t, v, ivec2(0, 1));
+        vec4 e = textureOffset(t, v, ivec2(1, 0));
+        vec4 w = textureOffset(t, v, ivec2(-1, 0));
+
+        float lC = dot(col.rgb, vec3(0.299, 0.587, 0.114));
+        float lN = dot(n.rgb, vec3(0.299, 0.587, 0.114));
+        float lS = dot(s.rgb, vec3(0.299, 0.587, 0.114));
+        float lE = dot(e.rgb, vec3(0.299, 0.587, 0.114));
+        float lW = dot(w.rgb, vec3(0.299, 0.587, 0.114));
+
+        float mx = max(lC, max(max(lN, lS), max(lE, lW)));
+        float mn = min(lC, min(min(lN, lS), min(lE, lW)));
+        float amt = sqrt(clamp(mn / (1.0 - mx + 0.001), 0.0, 1.0));
+
+        float peak = -1.0 / mix(8.0, 5.0, amt * p.a);
+        float sharpLuma = lC + (lN + lS + lE + lW) * peak;
+        sharpLuma /= (1.0 + 4.0 * peak);
+        col.rgb += (sharpLuma - lC);
+    }
+
+    // 2. VIBRANCE (Color Restoration)
+    float maxRGB = max(col.r, max(col.g, col.b));
+    float minRGB = min(col.r, min(col.g, col.b));
+    float sat = maxRGB - minRGB;
+    col.rgb = mix(col.rgb, vec3(maxRGB), (1.0 - pow(max(sat, 0.0), 0.5)) * -0.2);
+
+    // 3. ACES TONEMAP
+    vec3 x = max(col.rgb, 0.0);
+    col.rgb = clamp((x*(2.51*x+0.03))/(x*(2.43*x+0.59)+0.14), 0.0, 1.0);
+
+    // 4. ALPHA SAFETY
+    o = vec4(p.srgb != 0 ? decode(col.rgb) : col.rgb, 1.0);
+}
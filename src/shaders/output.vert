@@ -0,0 +1,8 @@
+#version 450
+// One triangle covering the screen
+layout(location = 0) out vec2 v;
+
+void main() {
+    v = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(v * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstdio>
+
+// Host tests: plain executables run by ctest. Exit 0 = pass, 77 = skipped
+// (no usable driver here), anything else = fail.
+#define CHECK(x) do{ if(!(x)){ fprintf(stderr,"%s:%d: CHECK(%s) failed\n",__FILE__,__LINE__,#x); return 1; } }while(0)
+#define CHECK_NEAR(a,b,tol) do{ double a_=(a), b_=(b); if(a_-b_>(tol) || b_-a_>(tol)){ \
+    fprintf(stderr,"%s:%d: %s = %g, expected %g +/- %g\n",__FILE__,__LINE__,#a,a_,b_,(double)(tol)); return 1; } }while(0)
+static const int SKIP = 77;
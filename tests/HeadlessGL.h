@@ -0,0 +1,38 @@
+#pragma once
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+#include <cstdio>
+
+// Headless context for the GL tests: Mesa's surfaceless platform with a pbuffer
+// standing in for the window (the same setup as tools/mbreplay.cpp). `extra`
+// adds config attributes (EGL_SAMPLES, EGL_STENCIL_SIZE, ...); api picks GLES 3
+// or a desktop GL 3.3 core context.
+struct HeadlessGL {
+    EGLDisplay dpy=EGL_NO_DISPLAY; EGLConfig cf=0; EGLContext ctx=EGL_NO_CONTEXT; EGLSurface srf=EGL_NO_SURFACE;
+
+    bool open(int w, int h, const EGLint* extra=0, EGLenum api=EGL_OPENGL_ES_API){
+        auto platform=(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        dpy=platform?platform(EGL_PLATFORM_SURFACELESS_MESA,EGL_DEFAULT_DISPLAY,0):eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        bool es=api==EGL_OPENGL_ES_API;
+        EGLint ca[32]={EGL_RENDERABLE_TYPE,es?EGL_OPENGL_ES3_BIT:EGL_OPENGL_BIT,EGL_SURFACE_TYPE,EGL_PBUFFER_BIT,
+                       EGL_RED_SIZE,8,EGL_GREEN_SIZE,8,EGL_BLUE_SIZE,8,EGL_ALPHA_SIZE,8};
+        int n=12; for(int i=0;extra && extra[i]!=EGL_NONE && n<30;i++) ca[n++]=extra[i];
+        ca[n]=EGL_NONE;
+        EGLint xes[]={EGL_CONTEXT_MAJOR_VERSION,3,EGL_NONE};
+        EGLint xgl[]={EGL_CONTEXT_MAJOR_VERSION,3,EGL_CONTEXT_MINOR_VERSION,3,EGL_CONTEXT_OPENGL_PROFILE_MASK,EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,EGL_NONE};
+        EGLint pa[]={EGL_WIDTH,w,EGL_HEIGHT,h,EGL_NONE}, got=0;
+        if(dpy==EGL_NO_DISPLAY || !eglInitialize(dpy,0,0) || !eglBindAPI(api) || !eglChooseConfig(dpy,ca,&cf,1,&got) || !got) return fail("no matching pbuffer config");
+        ctx=eglCreateContext(dpy,cf,EGL_NO_CONTEXT,es?xes:xgl);
+        srf=eglCreatePbufferSurface(dpy,cf,pa);
+        if(!ctx || !srf || !eglMakeCurrent(dpy,srf,srf,ctx)) return fail("can't make a pbuffer context current");
+        return true;
+    }
+    EGLint attrib(EGLint a) const { EGLint v=0; eglGetConfigAttrib(dpy,cf,a,&v); return v; }
+    bool fail(const char* why){ fprintf(stderr,"skipped: %s\n",why); return false; }
+    ~HeadlessGL(){ if(dpy!=EGL_NO_DISPLAY){ eglMakeCurrent(dpy,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT); eglTerminate(dpy); } }
+};
+
+// One RGBA8 pixel of the bound read framebuffer
+struct Pixel { int r, g, b, a; };
+inline Pixel readPixel(int x, int y){ unsigned char p[4]={}; glReadPixels(x,y,1,1,GL_RGBA,GL_UNSIGNED_BYTE,p); return {p[0],p[1],p[2],p[3]}; }
@@ -0,0 +1,101 @@
+// A/B statistics on known samples (no driver needed), then A/B on llvmpipe:
+// variants that share textures flip without a rebuild (Mesa never reuses texture
+// names, so a rebuild shows as a new capture texture). Variants that need one
+// rebuild on every flip and keep their first AB_REBUILD_WARMUP frames out of
+// the numbers; with blocks too short for that they are refused.
+#include <cstring>
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "Pipeline.h"
+#include "Config.h"
+
+static const int W=128, H=128;
+
+// Welford against the textbook two-pass values; AbMetric's block means and the
+// Welch interval against hand-computed ones
+static int stats(){
+    Welford w; for(double x:{2,4,4,4,5,5,7,9}) w.add(x);
+    CHECK(w.n==8); CHECK_NEAR(w.mean,5,1e-12); CHECK_NEAR(w.var(),32.0/7,1e-12);
+    Welford big; for(int i=0;i<1000;i++) big.add(1e9+(i&1));   // large offset, tiny spread
+    CHECK_NEAR(big.mean,1e9+0.5,1e-6); CHECK_NEAR(big.var(),0.25*1000/999,1e-6);
+
+    // Blocks alternate A, B, A, ...; each block's frames average into one observation
+    AbMetric m; double d=0, ci=0;
+    const double a[3]={10,12,14}, b[4]={20,22,24,26};
+    CHECK(!m.diff(d,ci));
+    for(int i=0;i<4;i++){
+        if(i<3) for(int f=-1;f<=1;f++) m.add(0,2*i,(uint64_t)(a[i]+f));   // mean a[i], spread within the block
+        m.add(1,2*i+1,(uint64_t)b[i]); m.add(1,2*i+1,(uint64_t)b[i]);
+    }
+    CHECK(m.blocks[1].n==3);   // the last block is still open
+    m.close();
+    CHECK(m.blocks[0].n==3 && m.blocks[1].n==4);
+    CHECK_NEAR(m.blocks[0].mean,12,1e-12); CHECK_NEAR(m.blocks[0].var(),4,1e-12);
+    CHECK_NEAR(m.blocks[1].mean,23,1e-12); CHECK_NEAR(m.blocks[1].var(),20.0/3,1e-12);
+    CHECK(m.diff(d,ci));
+    CHECK_NEAR(d,11,1e-12); CHECK_NEAR(ci,1.96*sqrt(4.0/3+20.0/3/4),1e-12);   // 1.96*sqrt(3)
+    m.reset(); CHECK(!m.diff(d,ci) && m.blocks[0].n==0);
+    return 0;
+}
+
+static void frames(int n, bool* seen=0){
+    for(int f=0;f<n;f++){
+        glBindFramebuffer(GL_FRAMEBUFFER,0); glClearColor(0.5f,0.3f,0.2f,1); glClear(GL_COLOR_BUFFER_BIT);
+        render(W,H,false);
+        if(seen && variant>=0) seen[variant]=true;
+    }
+}
+
+static void ab(int every, const char* a, const char* b){
+    AbConfig x; x.every=every; snprintf(x.over[0],sizeof(x.over[0]),"%s",a); snprintf(x.over[1],sizeof(x.over[1]),"%s",b);
+    abConfig.store(x);
+}
+
+int main(){
+    if(stats()) return 1;
+    HeadlessGL gl;
+    if(!gl.open(W,H)) return SKIP;
+    Config c; c.maskShape=MASK_NONE; c.sharpen=0.3f; config.store(c);
+    frames(4);
+    GLuint t0=frameTextures().capture;
+    CHECK(t0 && glGetError()==GL_NO_ERROR);
+
+    // Sharpen strength and the mask: flips are free
+    bool seen[2]={};
+    ab(2*AB_WARMUP,"sharpen=0.3","sharpen=0.6 mask=circle");
+    frames(8*AB_WARMUP,seen);
+    CHECK(seen[0] && seen[1] && abWarmup==AB_WARMUP);
+    CHECK(frameTextures().capture==t0);
+
+    // Scale differs with blocks too short to absorb a rebuild: A/B goes off
+    ab(2*AB_WARMUP,"scale=0.5","scale=1");
+    frames(8*AB_WARMUP);
+    CHECK(variant==-1 && frameTextures().capture==t0 && cfg.scale==c.scale);
+
+    // ... with long enough blocks it rebuilds at each flip, outside the measured frames
+    const int every=2*AB_REBUILD_WARMUP;
+    bool both[2]={}; int sampled=0;
+    frames(1); GLuint last=frameTextures().capture>t0?frameTextures().capture:t0;   // newest name in the ring
+    ab(every,"scale=0.5","scale=1");
+    int rebuilt=0;
+    for(int f=0;f<4*every;f++){
+        frames(1,both);
+        if(abSample()) sampled++;
+        CHECK(variant<0 || cfg.scale==(variant?1.0f:0.5f));
+        GLuint t=frameTextures().capture; if(t>last){ rebuilt++; last=t; CHECK(abPos==0 && !abSample()); }   // names only grow
+    }
+    CHECK(both[0] && both[1] && abWarmup==AB_REBUILD_WARMUP);
+    CHECK(rebuilt>=3 && sampled>=4*(every-AB_REBUILD_WARMUP)-every);
+
+    // Sharpen on/off needs the other draw program: same rule
+    ab(2*AB_WARMUP,"sharpen=0","sharpen=0.5");
+    frames(8*AB_WARMUP);
+    CHECK(variant==-1);
+    bool sh[2]={};
+    ab(every,"sharpen=0","sharpen=0.5");
+    frames(4*every,sh);
+    CHECK(sh[0] && sh[1] && abWarmup==AB_REBUILD_WARMUP);
+    CHECK(glGetError()==GL_NO_ERROR);
+    printf("ab: flips kept texture %u, %d rebuilds at flips, short rebuild blocks refused\n",t0,rebuilt);
+    return 0;
+}
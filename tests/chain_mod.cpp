@@ -0,0 +1,37 @@
+// A stand-in mod for chain_test, built twice as a shared library with
+// PresentChain.cpp and nothing of the pipeline (GLState.h must stay free of it).
+// CHAIN_MOD=0: order -5, paints the left half red, needs the surface copied out.
+// CHAIN_MOD=1: order 5, paints the top half green, reads the surface itself.
+// Both answer present_chain_v1 from load; chain_mod_start() elects and registers.
+#include <GLES3/gl3.h>
+#include "PresentChain.h"
+
+#define EXPORT extern "C" __attribute__((visibility("default")))
+
+static const int ORDER = CHAIN_MOD==0 ? -5 : 5;
+static const unsigned FLAGS = CHAIN_MOD==0 ? 0 : PRESENT_READS_SURFACE;
+
+// Copies input to output, then one flat rectangle over it
+static void paint(const PresentTarget* t, void*){
+    int w=t->width, h=t->height;
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,t->input_fbo); glBindFramebuffer(GL_DRAW_FRAMEBUFFER,t->output_fbo);
+    if(t->input_fbo!=t->output_fbo) glBlitFramebuffer(0,0,w,h,0,0,w,h,GL_COLOR_BUFFER_BIT,GL_NEAREST);
+    glEnable(GL_SCISSOR_TEST);
+    if(CHAIN_MOD==0){ glScissor(0,0,w/2,h); glClearColor(1,0,0,1); }
+    else { glScissor(0,h/2,w,h-h/2); glClearColor(0,1,0,1); }
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+__attribute__((constructor)) static void load(){ presentChainEnable(true); }
+
+// 1 = this library hosts, 0 = joined another one's chain
+EXPORT int chain_mod_start(void){
+    PresentChain* host=presentChainFind();
+    PresentEffect e={sizeof(PresentEffect),CHAIN_MOD==0?"red":"green",ORDER,FLAGS,paint,0};
+    host->add(&e);
+    return host==presentChainLocal();
+}
+
+// The host's swap hook would call this before the real swap
+EXPORT int chain_mod_present(void* display, void* surface, int w, int h){ return presentChainLocal()->run(display,surface,w,h,0); }
@@ -0,0 +1,43 @@
+// Two stand-in mods (chain_mod.cpp, paths in argv) sharing one present chain in
+// a surfaceless EGL app: the first-loaded one hosts whichever asks first, the
+// effects run by order rather than registration through the intermediate
+// textures, the host's copy of the surface ignores the app's scissor, and the
+// app's state comes back.
+#include <dlfcn.h>
+#include "Check.h"
+#include "HeadlessGL.h"
+
+static const int W=128, H=96;
+
+int main(int argc, char** argv){
+    if(argc<3) return 1;
+    HeadlessGL ctx;
+    if(!ctx.open(W,H)) return SKIP;
+    void* a=dlopen(argv[1],RTLD_NOW|RTLD_LOCAL);
+    void* b=dlopen(argv[2],RTLD_NOW|RTLD_LOCAL);
+    CHECK(a && b);
+    auto startA=(int(*)())dlsym(a,"chain_mod_start"), startB=(int(*)())dlsym(b,"chain_mod_start");
+    auto present=(int(*)(void*,void*,int,int))dlsym(a,"chain_mod_present");
+    CHECK(startA && startB && present);
+    CHECK(startB()==0);   // joins a, though a has registered nothing yet
+    CHECK(startA()==1);
+
+    // The app's frame: blue, with state it expects to keep
+    glClearColor(0,0,1,1); glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_SCISSOR_TEST); glScissor(1,2,3,4); glClearColor(0.25f,0.5f,0.75f,1);
+    CHECK(present(ctx.dpy,ctx.srf,W,H)==2);
+    CHECK(glGetError()==GL_NO_ERROR);
+
+    // red (order -5) first, green (order 5) over it
+    Pixel tl=readPixel(W/4,3*H/4), tr=readPixel(3*W/4,3*H/4), bl=readPixel(W/4,H/4), br=readPixel(3*W/4,H/4);
+    CHECK(tl.g==255 && tl.r==0 && tr.g==255);
+    CHECK(bl.r==255 && bl.g==0);
+    CHECK(br.b==255 && br.r==0 && br.g==0);   // the surface made it through the host's copy whole
+
+    GLint box[4]; GLfloat clear[4];
+    CHECK(glIsEnabled(GL_SCISSOR_TEST));
+    glGetIntegerv(GL_SCISSOR_BOX,box); CHECK(box[0]==1 && box[1]==2 && box[2]==3 && box[3]==4);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE,clear); CHECK(clear[0]==0.25f && clear[2]==0.75f);
+    printf("chain: b joined a, red then green, state kept\n");
+    return 0;
+}
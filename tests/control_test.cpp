@@ -0,0 +1,134 @@
+// Control socket on the host: the real server (Control.cpp) on a private abstract
+// name, driven line by line like adb forward would. Every command, with stand-in
+// handlers for the mod's side, including the malformed arguments it must refuse. Another uid is turned away
+// before it can send a command (checked by forking a child that drops to one,
+// when the test runs as root).
+#include "Check.h"
+#include "Control.h"
+#include "Config.h"
+#include "Recorder.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+static char name[64];
+
+static int connectTo(){
+    int s=socket(AF_UNIX,SOCK_STREAM,0);
+    sockaddr_un a={}; a.sun_family=AF_UNIX; strcpy(a.sun_path+1,name);
+    if(connect(s,(sockaddr*)&a,offsetof(sockaddr_un,sun_path)+1+strlen(name))<0){ close(s); return -1; }
+    return s;
+}
+static std::string reply(int s){
+    std::string r; char c;
+    while(read(s,&c,1)==1 && c!='\n') r+=c;
+    return r;
+}
+static std::string ask(int s, const char* line){ write(s,line,strlen(line)); return reply(s); }
+
+// Stand-ins for the mod's side: what each command was asked to do
+static int benched=-1, recKind=-1, recFrames=-2, dumps=0;
+static bool ring=false;
+static const ControlHandlers handlers={
+    0,
+    [](int fd, int sec){ benched=sec; dprintf(fd,"ok seconds=%d\n",sec); },
+    [](){ Stats s={}; s.frames=42; s.fps=30; s.width=640; strcpy(s.capture,"blit"); return s; },
+    [](int kind, int frames){ recKind=kind; recFrames=frames; },
+    [](){ if(ring) dumps++; return ring; },
+    [](int fd){ dprintf(fd,"ok every=%d\n",abConfig.load().every); },
+};
+
+int main(){
+    CHECK(controlAllowed(getuid()) && controlAllowed(SHELL_UID));
+    CHECK(!controlAllowed(getuid()+12345));
+
+    snprintf(name,sizeof(name),"motionblur_test_%d",(int)getpid());
+    int srv=controlListen(name);
+    CHECK(srv>=0);
+    CHECK(controlListen(name)<0);   // the name is taken
+    pthread_t t; pthread_create(&t,0,[](void* p)->void*{ controlServe((int)(intptr_t)p,handlers); return 0; },(void*)(intptr_t)srv);
+
+    int c=connectTo(); CHECK(c>=0);
+    CHECK(ask(c,"get scale\n")=="ok scale=0.5");
+    CHECK(ask(c,"set scale 0.75\n")=="ok");
+    CHECK(config.load().scale==0.75f);
+    CHECK(ask(c,"get scale\n")=="ok scale=0.75");
+    CHECK(ask(c,"set nope 1\n")=="err bad set");
+    CHECK(ask(c,"get nope\n")=="err unknown key nope");
+    CHECK(ask(c,"set mask circle\n")=="ok" && config.load().maskShape==MASK_CIRCLE);
+    CHECK(ask(c,"set mask cirlce\n")=="err bad set" && config.load().maskShape==MASK_CIRCLE);   // a typo is not an ellipse
+    CHECK(ask(c,"set trace yes\n")=="err bad set");
+    CHECK(ask(c,"preset performance\n")=="ok");
+    CHECK(config.load().checkerboard);
+    CHECK(ask(c,"set scale\n")=="err bad set" && ask(c,"set scale 0.5 0.6\n")=="err bad set" && ask(c,"preset\n")=="err bad preset");
+    CHECK(ask(c,"get scale sharpen\n")=="err usage: get [key]");
+    CHECK(ask(c,"bogus\n")=="err unknown command bogus");
+
+    // bench: whole seconds in 1..BENCH_MAX, nothing measured otherwise
+    CHECK(ask(c,"bench 3\n")=="ok seconds=3" && benched==3);
+    benched=-1;
+    for(const char* bad:{"bench\n","bench 0\n","bench 10\n","bench 2x\n","bench -1\n","bench 1 2\n","bench 99999999999999999999\n"})
+        CHECK(ask(c,bad)=="err usage: bench seconds(1-9)");
+    CHECK(benched==-1);
+
+    CHECK(ask(c,"dump-stats\n").rfind("ok frames=42 skipped=0 fps=30.0 ",0)==0);
+    CHECK(ask(c,"dump-stats\n").find(" width=640 ")!=std::string::npos && ask(c,"dump-stats\n").find(" path=blit ")!=std::string::npos);
+    CHECK(ask(c,"dump-stats now\n")=="err usage: dump-stats");
+
+    // screenshot and record: seconds become frames at the published rate
+    CHECK(ask(c,"screenshot\n")=="ok" && recKind==REC_PNG && recFrames==1);
+    CHECK(ask(c,"record\n")=="ok" && recKind==REC_Y4M && recFrames==-1);
+    CHECK(ask(c,"record 2.5\n")=="ok" && recFrames==75);
+    CHECK(ask(c,"record stop\n")=="ok" && recFrames==0);
+    recKind=recFrames=-2;
+    CHECK(ask(c,"screenshot now\n")=="err usage: screenshot");
+    for(const char* bad:{"record 0\n","record -2\n","record 5s\n","record nan\n","record 601\n","record 1 2\n","record stopp\n"})
+        CHECK(ask(c,bad)=="err usage: record [seconds(<=600)|stop]");
+    CHECK(recKind==-2 && recFrames==-2);
+
+    // dump: only with a ring
+    CHECK(ask(c,"dump\n")=="err dump_seconds is 0" && dumps==0);
+    ring=true;
+    CHECK(ask(c,"dump\n")=="ok" && dumps==1);
+    CHECK(ask(c,"dump all\n")=="err usage: dump" && dumps==1);
+
+    // ab: N, exactly one bar, valid keys on both sides; anything else leaves A/B as it was
+    CHECK(ask(c,"ab 40 sharpen=0.3 | sharpen=0.6 mask=circle\r\n")=="ok");
+    AbConfig a=abConfig.load();
+    CHECK(a.every==40 && !strcmp(a.over[0],"sharpen=0.3") && !strcmp(a.over[1],"sharpen=0.6 mask=circle"));
+    CHECK(ask(c,"ab\n")=="ok every=40");
+    CHECK(ask(c,"  ab 16|mask=none|\n").rfind("err usage: ab",0)==0);
+    for(const char* bad:{"ab 40\n","ab x | y\n","ab 8 sharpen=0.3 | sharpen=0.6\n","ab 40x sharpen=0.3 | sharpen=0.6\n","ab | sharpen=0.6\n",
+                         "ab 99999999999999999999 sharpen=0.3 | sharpen=0.6\n","ab off now\n","ab 40 a | b | c\n"})
+        CHECK(ask(c,bad).rfind("err usage: ab",0)==0);
+    CHECK(ask(c,"ab 40 bogus=1 | sharpen=0.6\n")=="err bad keys");
+    CHECK(ask(c,"ab 40 scale=0.5 | scale=1\n").rfind("err ab variants that rebuild",0)==0);
+    CHECK(ask(c,"ab 60 scale=0.5 | scale=1\n")=="ok" && abConfig.load().every==60);
+    std::string longKeys="ab 40 "+std::string(120,'x')+" | sharpen=0.6\n";
+    CHECK(ask(c,longKeys.c_str())=="err ab keys too long");
+    CHECK(abConfig.load().every==60);
+    CHECK(ask(c,"ab off\n")=="ok" && abConfig.load().every==0);
+    close(c);
+
+    if(getuid()==0){
+        pid_t p=fork();
+        if(p==0){
+            if(setuid(12345)!=0) _exit(2);
+            signal(SIGPIPE,SIG_IGN);   // the server may already have hung up
+            int s=connectTo(); if(s<0) _exit(3);
+            write(s,"set scale 0.25\n",15);
+            _exit(reply(s)=="err not allowed" ? 0 : 1);
+        }
+        int st=0; waitpid(p,&st,0);
+        CHECK(WIFEXITED(st) && WEXITSTATUS(st)==0);
+        CHECK(config.load().scale==0.75f);   // the command never ran
+    }
+    else printf("control: not root, foreign uid rejection not exercised\n");
+    return 0;
+}
@@ -0,0 +1,42 @@
+// Damage on llvmpipe: capture and blur stay inside the damage, but the draw pass
+// covers the whole surface unless the buffer holds our own output around it.
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "Pipeline.h"
+
+static const int W=256, H=128;
+
+static void fill(float r, float g, float b){
+    glBindFramebuffer(GL_FRAMEBUFFER,0); glViewport(0,0,W,H); glClearColor(r,g,b,1); glClear(GL_COLOR_BUFFER_BIT);
+}
+
+int main(){
+    HeadlessGL gl;
+    if(!gl.open(W,H)) return SKIP;
+    for(int f=0;f<60;f++){ fill(1,0,0); render(W,H,false); }   // settle the history on the full frame
+
+    // Unknown age: the game redrew everything raw, a small damage must not leave the rest ungraded
+    Rect d={8,8,40,40};
+    for(int f=0;f<DECAY_FRAMES+2;f++){ fill(1,0,0); bufferAge=0; render(W,H,false,&d); }
+    CHECK(glGetError()==GL_NO_ERROR);
+    CHECK(processed.x1<W/2);   // only the damage (and its decay margin) is processed
+    Pixel far=readPixel(W-4,H-4);
+    CHECK_NEAR(far.r,205,6);
+
+    // Preserved: outside the processed area the buffer is ours already and is left alone
+    fill(0,1,0); bufferAge=1; render(W,H,false,&d);
+    Pixel in=readPixel(20,20), out=readPixel(W-4,H-4);
+    CHECK(in.g<250 && out.g==255);   // inside: blurred into the red history and graded
+
+    // Age 3: repairs what the two previous frames processed as well
+    Rect a={8,8,40,40}, b={200,80,240,120}, c={100,40,120,60};
+    bufferAge=0; fill(1,0,0); render(W,H,false,&a); render(W,H,false,&b);
+    Rect r=repairRegion(3);
+    CHECK(r.x0<=a.x0 && r.y0<=a.y0 && r.x1>=b.x1 && r.y1>=b.y1);
+    fill(0,1,0); bufferAge=3; render(W,H,false,&c);
+    CHECK(readPixel(220,100).g<250 && readPixel(20,20).g<250);   // inside b and a: repaired
+    CHECK(readPixel(W-4,H/2).g==255);                        // outside all three: untouched
+    printf("damage: processed (%d,%d)-(%d,%d), far %d, repair (%d,%d)-(%d,%d)\n",
+        processed.x0,processed.y0,processed.x1,processed.y1,far.r,r.x0,r.y0,r.x1,r.y1);
+    return 0;
+}
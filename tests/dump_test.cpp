@@ -0,0 +1,74 @@
+// Frame dump: the ring is a mapped file that wraps, and a save writes the
+// frames still in it oldest first with the surface fields of the header. A
+// child that fills a ring and aborts leaves it readable on disk, which is what
+// the file is for. With a path argument the dump is also left there for the
+// mbreplay smoke run.
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <GLES3/gl3.h>
+#include "Check.h"
+#include "FrameDump.h"
+
+static const int SLOTS=6, SIZE=32, W=320, H=180;
+
+static void fill(DumpHeader* h, uint32_t n){
+    for(uint32_t i=0;i<n;i++){
+        DumpFrame* f=dumpSlot(h,h->written);
+        *f={i*16666667ull,i,W,H,SIZE,SIZE*H/W,{0,0,W,H},1,0,{}};
+        memset(dumpPixels(f),(int)(i*20),(size_t)SIZE*SIZE*4);
+        h->written++;
+    }
+    h->samples=4; h->fmt=GL_RGBA8; h->redirect=1; h->gameScale=0.5f;
+    snprintf(h->config,sizeof(h->config),"mask=none ring=2 scale=0.5");
+}
+
+int main(int argc, char** argv){
+    char dir[]="/tmp/dump_testXXXXXX", path[256], ringPath[256];
+    CHECK(mkdtemp(dir));
+    snprintf(ringPath,sizeof(ringPath),"%s/motionblur.ring",dir);
+
+    // Crash with a full ring: nothing unmapped or saved, the file has it all
+    pid_t p=fork();
+    if(p==0){
+        DumpHeader* c=dumpOpen(ringPath,SLOTS,SIZE);
+        if(!c) _exit(1);
+        fill(c,10);
+        abort();
+    }
+    int st=0; waitpid(p,&st,0);
+    CHECK(WIFSIGNALED(st));
+    int fd=open(ringPath,O_RDONLY); CHECK(fd>=0);
+    const DumpHeader* r=(const DumpHeader*)mmap(0,dumpBytes(SLOTS,sizeof(DumpFrame)+SIZE*SIZE*4),PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    CHECK(r!=MAP_FAILED && !memcmp(r->magic,"MBFD",4) && r->written==10 && r->samples==4 && !strcmp(r->config,"mask=none ring=2 scale=0.5"));
+    for(uint32_t i=4;i<10;i++) CHECK(dumpSlot(r,i)->frame==i && dumpPixels(dumpSlot(r,i))[0]==(uint8_t)(i*20));
+    munmap((void*)r,dumpBytes(SLOTS,sizeof(DumpFrame)+SIZE*SIZE*4));
+
+    // A new ring on the same path starts empty
+    DumpHeader* h=dumpOpen(ringPath,SLOTS,SIZE);
+    CHECK(h && h->version==DUMP_VERSION && h->slots==SLOTS && !h->written);
+    fill(h,10);
+    CHECK(dumpSave(h,dir,path,sizeof(path)));
+    FILE* f=fopen(path,"rb"); CHECK(f);
+    DumpHeader d; CHECK(fread(&d,sizeof(d),1,f)==1);
+    CHECK(d.version==DUMP_VERSION && d.slots==SLOTS && d.written==SLOTS && d.samples==4 && d.redirect==1 && d.gameScale==0.5f);
+    CHECK(!strcmp(d.config,"mask=none ring=2 scale=0.5"));
+    for(uint32_t i=0;i<SLOTS;i++){
+        DumpFrame x; CHECK(fread(&x,sizeof(x),1,f)==1);
+        uint8_t p; CHECK(fread(&p,1,1,f)==1);
+        CHECK(x.frame==4+i && p==(uint8_t)((4+i)*20));
+        fseek(f,d.slotBytes-sizeof(x)-1,SEEK_CUR);
+    }
+    fclose(f);
+    if(argc>1) CHECK(rename(path,argv[1])==0);
+    else unlink(path);
+    dumpClose(h);
+    unlink(ringPath); rmdir(dir);
+    printf("dump: %d of 10 frames survived a crash, saved in order\n",SLOTS);
+    return 0;
+}
@@ -0,0 +1,40 @@
+// Foveated draw pass on llvmpipe: level 0 runs the sharpened program, the outer
+// bands the plain one. A flat scene must come out the same graded grey in the
+// centre and in every band (each program carries its own uniforms), and a hard
+// edge is sharpened only in the centre.
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "Pipeline.h"
+#include "Config.h"
+
+static const int W=256, H=256;
+
+int main(){
+    HeadlessGL gl;
+    if(!gl.open(W,H)) return SKIP;
+    Config c; c.foveaLevels=3; c.maskShape=MASK_NONE; c.sharpen=1.0f; config.store(c);
+
+    // Flat grey
+    for(int f=0;f<30;f++){
+        glBindFramebuffer(GL_FRAMEBUFFER,0); glClearColor(0.5f,0.5f,0.5f,1); glClear(GL_COLOR_BUFFER_BIT);
+        render(W,H,false);
+    }
+    CHECK(glGetError()==GL_NO_ERROR && levels==3);
+    Pixel m=readPixel(W/2,H/2), e=readPixel(2,H/2), k=readPixel(W-3,H-3);
+    CHECK(m.r>0 && abs(e.r-m.r)<=2 && abs(k.r-m.r)<=2);
+
+    // A vertical edge through the centre and the outer bands: CAS overshoots it in the centre only
+    for(int f=0;f<30;f++){
+        glBindFramebuffer(GL_FRAMEBUFFER,0); glClearColor(0.2f,0.2f,0.2f,1); glClear(GL_COLOR_BUFFER_BIT);
+        glEnable(GL_SCISSOR_TEST); glScissor(W/2,0,W/2,H); glClearColor(0.6f,0.6f,0.6f,1); glClear(GL_COLOR_BUFFER_BIT); glDisable(GL_SCISSOR_TEST);
+        render(W,H,false);
+    }
+    CHECK(glGetError()==GL_NO_ERROR);
+    int centre=0, outer=0;
+    Pixel hi=readPixel(3*W/4,H/2), hiOut=readPixel(3*W/4,2);
+    for(int x=W/2-6;x<W/2+6;x++){ centre=fmax(centre,readPixel(x,H/2).r); outer=fmax(outer,readPixel(x,2).r); }
+    CHECK(centre>hi.r+2);       // overshoot next to the edge
+    CHECK(outer<=hiOut.r+1);    // none in the outer band
+    printf("fovea: flat %d/%d/%d, edge peak centre %d (flat %d) outer %d (flat %d)\n",m.r,e.r,k.r,centre,hi.r,outer,hiOut.r);
+    return 0;
+}
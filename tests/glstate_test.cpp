@@ -0,0 +1,48 @@
+// GLState around render(): the scene capture runs the pipeline between two of
+// the game's draws, including the first-frame rebuild in initGL()/buildMesh().
+// Everything the game had set must come back exactly.
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "GLState.h"
+#include "Pipeline.h"
+
+int main(){
+    const int W=192, H=108;
+    HeadlessGL gl;
+    EGLint stencil[]={EGL_STENCIL_SIZE,8,EGL_NONE};   // the stencil reference reads back clamped to the surface's bits
+    if(!gl.open(W,H,stencil)) return SKIP;
+
+    // The game's state halfway through its frame
+    GLuint buf, rbo, tex[3];
+    glGenBuffers(1,&buf); glBindBuffer(GL_ARRAY_BUFFER,buf);
+    glGenRenderbuffers(1,&rbo); glBindRenderbuffer(GL_RENDERBUFFER,rbo);
+    glGenTextures(3,tex);
+    glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_2D,tex[2]);
+    glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_2D,tex[1]);
+    glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D,tex[0]);
+    glClearColor(0.25f,0.5f,0.75f,1.0f); glClearStencil(3);
+    glVertexAttrib4f(2,0.5f,0.25f,0.125f,1.0f);
+    glViewport(3,4,50,60); glScissor(5,6,70,80); glEnable(GL_SCISSOR_TEST); glEnable(GL_BLEND);
+    glStencilFunc(GL_LEQUAL,5,0x0F); glStencilMask(0x3C);
+
+    for(int f=0;f<3;f++){ GLState st; st.save(); render(W,H,false); st.restore(); }
+
+    GLint v[4]; GLfloat c[4];
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING,v); CHECK(v[0]==(GLint)buf);
+    glGetIntegerv(GL_RENDERBUFFER_BINDING,v); CHECK(v[0]==(GLint)rbo);
+    glGetIntegerv(GL_ACTIVE_TEXTURE,v); CHECK(v[0]==GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D,v); CHECK(v[0]==(GLint)tex[0]);
+    glActiveTexture(GL_TEXTURE1); glGetIntegerv(GL_TEXTURE_BINDING_2D,v); CHECK(v[0]==(GLint)tex[1]);
+    glActiveTexture(GL_TEXTURE2); glGetIntegerv(GL_TEXTURE_BINDING_2D,v); CHECK(v[0]==(GLint)tex[2]); glActiveTexture(GL_TEXTURE0);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE,c); CHECK(c[0]==0.25f && c[1]==0.5f && c[2]==0.75f && c[3]==1.0f);
+    glGetIntegerv(GL_STENCIL_CLEAR_VALUE,v); CHECK(v[0]==3);
+    glGetVertexAttribfv(2,GL_CURRENT_VERTEX_ATTRIB,c); CHECK(c[0]==0.5f && c[1]==0.25f && c[2]==0.125f && c[3]==1.0f);
+    glGetIntegerv(GL_VIEWPORT,v); CHECK(v[0]==3 && v[1]==4 && v[2]==50 && v[3]==60);
+    glGetIntegerv(GL_SCISSOR_BOX,v); CHECK(v[0]==5 && v[1]==6 && v[2]==70 && v[3]==80);
+    CHECK(glIsEnabled(GL_SCISSOR_TEST) && glIsEnabled(GL_BLEND) && !glIsEnabled(GL_DEPTH_TEST));
+    glGetIntegerv(GL_STENCIL_FUNC,v); CHECK(v[0]==GL_LEQUAL);
+    glGetIntegerv(GL_STENCIL_REF,v); CHECK(v[0]==5);
+    glGetIntegerv(GL_STENCIL_VALUE_MASK,v); CHECK(v[0]==0x0F);
+    glGetIntegerv(GL_STENCIL_WRITEMASK,v); CHECK(v[0]==0x3C);
+    return 0;
+}
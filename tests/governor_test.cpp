@@ -0,0 +1,79 @@
+// Quality governor on a fake sysfs tree: governorRead() picks the hottest
+// cpu/gpu/soc/skin zone and the battery, Governor::update() climbs at once and
+// steps down one level per HOLD calm samples, Governor::apply() only lowers.
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include "Check.h"
+#include "Governor.h"
+
+static std::string root;
+
+static void put(const char* rel, const char* v){
+    std::string p=root+"/"+rel;
+    for(size_t i=root.size()+1;(i=p.find('/',i))!=std::string::npos;i++) mkdir(p.substr(0,i).c_str(),0755);
+    FILE* f=fopen(p.c_str(),"w"); fprintf(f,"%s\n",v); fclose(f);
+}
+static void temp(const char* millis){ put("class/thermal/thermal_zone1/temp",millis); }
+
+int main(){
+    char dir[]="/tmp/governor_testXXXXXX";
+    if(!mkdtemp(dir)) return 1;
+    root=dir;
+    put("class/thermal/thermal_zone0/type","pa-therm"); put("class/thermal/thermal_zone0/temp","60000");   // not a zone we act on
+    put("class/thermal/thermal_zone1/type","cpu-0-0"); temp("41000");
+    put("class/thermal/thermal_zone2/type","gpu"); put("class/thermal/thermal_zone2/temp","0");           // disabled sensor
+    put("class/thermal/thermal_zone3/type","soc"); put("class/thermal/thermal_zone3/temp","200000");      // bogus
+    put("class/power_supply/usb/type","USB");
+    put("class/power_supply/battery/type","Battery"); put("class/power_supply/battery/capacity","80");
+    put("class/power_supply/battery/status","Discharging");
+
+    GovernorSample s=governorRead(dir);
+    CHECK_NEAR(s.temp,41.0,0.01); CHECK(s.battery==80 && !s.charging);
+    Governor g;
+    CHECK(g.update(s)==0);
+
+    // Climbs as soon as a threshold is crossed
+    temp("46500");
+    CHECK(g.update(governorRead(dir))==2);
+    temp("51000");
+    CHECK(g.update(governorRead(dir))==3);
+
+    // 45.5 C: still within HYSTERESIS of level 2's threshold, so one step per HOLD samples
+    temp("45500");
+    for(int i=0;i<Governor::HOLD-1;i++) CHECK(g.update(governorRead(dir))==3);
+    CHECK(g.update(governorRead(dir))==2);
+    for(int i=0;i<3*Governor::HOLD;i++) g.update(governorRead(dir));
+    CHECK(g.level==2);
+    temp("38000");   // below every threshold less HYSTERESIS
+    for(int i=0;i<2*Governor::HOLD;i++) g.update(governorRead(dir));
+    CHECK(g.level==0);
+
+    // Low battery unplugged; plugging in lets it recover
+    put("class/power_supply/battery/capacity","8");
+    CHECK(g.update(governorRead(dir))==2);
+    put("class/power_supply/battery/status","Charging");
+    s=governorRead(dir); CHECK(s.battery==8 && s.charging);
+    for(int i=0;i<2*Governor::HOLD;i++) g.update(s);
+    CHECK(g.level==0);
+
+    // No recognisable zone names: the hottest of all of them
+    put("class/thermal/thermal_zone1/type","tz1"); put("class/thermal/thermal_zone2/type","tz2"); put("class/thermal/thermal_zone3/type","tz3");
+    CHECK_NEAR(governorRead(dir).temp,60.0,0.01);
+    CHECK(governorRead("/nonexistent").temp<0 && governorRead("/nonexistent").battery<0);
+
+    // Steps never raise quality
+    Config c; c.sharpen=0.8f; c.scale=0.5f; c.checkerboard=true;
+    Config a=c; Governor::apply(a,1); CHECK(a.sharpen==0 && a.scale==0.5f && a.checkerboard);
+    a=c; Governor::apply(a,2); CHECK(a.scale==Governor::SCALE && a.checkerboard);
+    c.scale=0.25f; c.checkerboard=false;
+    a=c; Governor::apply(a,2); CHECK(a.scale==0.25f && !a.checkerboard);
+    a=c; Governor::apply(a,3); CHECK(a.scale==0.25f && a.checkerboard);
+    a=c; Governor::apply(a,0); CHECK(a.sharpen==c.sharpen && a.scale==c.scale);
+
+    std::string rm="rm -rf "+root; if(system(rm.c_str())){}
+    printf("governor: sysfs read, climb, hold, battery and apply ok\n");
+    return 0;
+}
@@ -0,0 +1,65 @@
+// PresentLatency against a scripted compositor: FrameTimestampsApi filled with
+// fakes that report a frame's GPU-done and on-screen times one swap after its
+// own. Covers pending results, a frame the compositor dropped, one the driver
+// forgot, an unsupported surface and a surface switch.
+#include "Check.h"
+#include "Latency.h"
+
+static const uint64_t MS=1000000;
+static EGLSurface A=(EGLSurface)1, B=(EGLSurface)2;   // B: no present timestamps
+static EGLuint64KHR nextId=100, swapped=100;          // ids handed out, swaps done
+static int attribCalls=0;
+
+static EGLBoolean supported(EGLDisplay, EGLSurface s, EGLint){ return s==A; }
+static EGLBoolean nextFrameId(EGLDisplay, EGLSurface, EGLuint64KHR* id){ *id=nextId; return EGL_TRUE; }
+static EGLBoolean surfaceAttrib(EGLDisplay, EGLSurface, EGLint a, EGLint v){ attribCalls++; return a==EGL_TIMESTAMPS_ANDROID && v==EGL_TRUE; }
+// Frame k (id 100+k) was requested at 16k ms: GPU done 5 ms later, on screen 30 ms later
+static EGLBoolean timestamps(EGLDisplay, EGLSurface, EGLuint64KHR id, EGLint n, const EGLint* names, EGLnsecsANDROID* v){
+    int k=(int)(id-100);
+    if(k==9) return EGL_FALSE;   // the driver no longer knows this frame
+    for(int i=0;i<n;i++){
+        EGLnsecsANDROID t = names[i]==EGL_RENDERING_COMPLETE_TIME_ANDROID ? 5*MS : 30*MS;
+        v[i] = swapped<id+2 ? EGL_TIMESTAMP_PENDING_ANDROID : k==5 && names[i]==EGL_DISPLAY_PRESENT_TIME_ANDROID ? EGL_TIMESTAMP_INVALID_ANDROID : (EGLnsecsANDROID)(16*MS*k)+t;
+    }
+    return EGL_TRUE;
+}
+
+static PresentLatency lat;
+static void frame(EGLSurface s, int k){
+    lat.beforeSwap(0,s,16*MS*k,16*MS*k+1*MS);
+    nextId++; swapped++;   // the real swap
+    lat.poll(0,s);
+}
+
+int main(){
+    lat.api={supported,nextFrameId,timestamps,surfaceAttrib};
+    lat.ourGpu(2*MS);
+
+    // Unsupported: nothing is enabled or recorded
+    frame(B,0);
+    CHECK(!lat.ok && attribCalls==0 && lat.display.snapshot().count==0);
+
+    // 20 frames on A; results arrive one swap late, so the last one is still pending
+    nextId=swapped=100;
+    for(int k=0;k<20;k++) frame(A,k);
+    CHECK(lat.ok && attribCalls==1);
+    HistSnapshot g=lat.gpuDone.snapshot(), d=lat.display.snapshot(), e=lat.extra.snapshot();
+    CHECK(d.count==17);   // 20 - pending (19) - dropped (5) - forgotten (9)
+    CHECK(g.count==17 && e.count==17);
+    CHECK(d.max==30*MS && g.max==5*MS && e.max==3*MS);   // extra = 1 ms to submit + 2 ms of our GPU
+    int live=0; for(auto& f:lat.frames) live+=f.live;
+    CHECK(live==1);
+
+    // Switching surfaces forgets A's pending frames
+    frame(B,20);
+    live=0; for(auto& f:lat.frames) live+=f.live;
+    CHECK(live==0 && !lat.ok);
+    CHECK(lat.display.snapshot().count==17);
+
+    // rotate() drops the oldest window once all have turned over
+    for(int i=0;i<PresentLatency::WINDOWS;i++) lat.rotate();
+    CHECK(lat.display.snapshot().count==0);
+    printf("latency: gpu done max %.1f ms, on screen max %.1f ms, extra max %.1f ms over %llu frames\n",
+        g.max/1e6,d.max/1e6,e.max/1e6,(unsigned long long)d.count);
+    return 0;
+}
@@ -0,0 +1,39 @@
+// UI mask on llvmpipe with a stencil surface. A scene that never changes must not
+// be learned as HUD (the keep path would then skip the grade everywhere); a static
+// corner over a moving scene must be, and keep the game's own pixels.
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "Pipeline.h"
+
+static const int W=256, H=128;
+
+// Left three quarters flip red/blue when moving, the top-right corner stays white
+static void scene(int f, bool moving){
+    glBindFramebuffer(GL_FRAMEBUFFER,0); glViewport(0,0,W,H);
+    glClearColor(1,0,0,1); glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_SCISSOR_TEST);
+    if(moving && f&1){ glScissor(0,0,3*W/4,H); glClearColor(0,0,1,1); glClear(GL_COLOR_BUFFER_BIT); }
+    glScissor(3*W/4,H/2,W/4,H/2); glClearColor(1,1,1,1); glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+int main(){
+    HeadlessGL gl;
+    EGLint stencil[]={EGL_STENCIL_SIZE,8,EGL_NONE};
+    if(!gl.open(W,H,stencil)) return SKIP;
+    surf.stencil=gl.attrib(EGL_STENCIL_SIZE);
+    CHECK(surf.stencil==8);
+
+    for(int f=0;f<3*MASK_FRAMES;f++){ scene(f,false); render(W,H,true); }
+    CHECK(glGetError()==GL_NO_ERROR);
+    Pixel s=readPixel(W/8,H/4), hs=readPixel(7*W/8,3*H/4);
+    CHECK_NEAR(s.r,205,6);    // graded: nothing was learned
+    CHECK(hs.r<250);
+
+    for(int f=0;f<3*MASK_FRAMES;f++){ scene(f,true); render(W,H,true); }
+    CHECK(glGetError()==GL_NO_ERROR);
+    Pixel hm=readPixel(7*W/8,3*H/4);
+    CHECK(hm.r==255 && hm.g==255 && hm.b==255);   // learned as HUD: the game's own pixel
+    printf("mask: static scene (%d,%d,%d) corner (%d,%d,%d); moving corner (%d,%d,%d)\n",s.r,s.g,s.b,hs.r,hs.g,hs.b,hm.r,hm.g,hm.b);
+    return 0;
+}
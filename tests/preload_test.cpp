@@ -0,0 +1,69 @@
+// The Linux preload around a surfaceless EGL app (run by ctest with LD_PRELOAD
+// set): argv[1] "es" for a GLES 3 context, "gl" for a desktop GL core one. The
+// app sets state a desktop app might set once, swaps moving content through the
+// interposed eglSwapBuffers, and checks that the pipeline ran and that every
+// piece of that state came back, GL errors included.
+#include <dlfcn.h>
+#include <cstring>
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "GLState.h"
+#include "MotionBlurApi.h"
+
+static const int W=256, H=160;
+
+int main(int argc, char** argv){
+    bool gl=argc>1 && !strcmp(argv[1],"gl");
+    HeadlessGL ctx; EGLint stencil[]={EGL_STENCIL_SIZE,8,EGL_NONE};
+    if(!ctx.open(W,H,stencil,gl?EGL_OPENGL_API:EGL_OPENGL_ES_API)) return SKIP;
+    auto polygonMode=(void(*)(GLenum,GLenum))eglGetProcAddress("glPolygonMode");
+    if(gl && !polygonMode) return SKIP;
+
+    // Set once, relied on every frame
+    glEnable(GL_SCISSOR_TEST); glScissor(0,0,W,H);
+    glStencilFuncSeparate(GL_FRONT,GL_LEQUAL,5,0x0F); glStencilFuncSeparate(GL_BACK,GL_GREATER,7,0x33);
+    glStencilOpSeparate(GL_BACK,GL_INCR,GL_DECR,GL_INVERT); glStencilMaskSeparate(GL_BACK,0x0F);
+    glVertexAttrib4f(2,0.5f,0.25f,0.125f,1.0f);
+    if(gl){ glEnable(GLSTATE_FRAMEBUFFER_SRGB); polygonMode(GLSTATE_FRONT_AND_BACK,0x1B01); }   // GL_LINE
+    while(glGetError()!=GL_NO_ERROR){}
+
+    // A white bar moving over black: the pipeline grades white to ~205 and leaves a trail
+    for(int f=0;f<30;f++){
+        glClearColor(0,0,0,1); glClear(GL_COLOR_BUFFER_BIT);
+        glScissor(f*6,0,40,H); glClearColor(1,1,1,1); glClear(GL_COLOR_BUFFER_BIT); glScissor(0,0,W,H);
+        CHECK(glGetError()==GL_NO_ERROR);
+        eglSwapBuffers(ctx.dpy,ctx.srf);
+        CHECK(glGetError()==GL_NO_ERROR);
+    }
+    Pixel bar=readPixel(29*6+20,H/2), trail=readPixel(29*6-4,H/2);
+    CHECK(bar.r>150 && bar.r<240);   // graded: the pipeline ran
+    CHECK(trail.r>10);               // blurred: history behind the bar
+
+    GLint v[2]={0,0};
+    CHECK(glIsEnabled(GL_SCISSOR_TEST));
+    glGetIntegerv(GL_STENCIL_FUNC,v); CHECK(v[0]==GL_LEQUAL);
+    glGetIntegerv(GL_STENCIL_BACK_FUNC,v); CHECK(v[0]==GL_GREATER);
+    glGetIntegerv(GL_STENCIL_BACK_REF,v); CHECK(v[0]==7);
+    glGetIntegerv(GL_STENCIL_BACK_VALUE_MASK,v); CHECK(v[0]==0x33);
+    glGetIntegerv(GL_STENCIL_BACK_FAIL,v); CHECK(v[0]==GL_INCR);
+    glGetIntegerv(GL_STENCIL_BACK_PASS_DEPTH_FAIL,v); CHECK(v[0]==GL_DECR);
+    glGetIntegerv(GL_STENCIL_BACK_PASS_DEPTH_PASS,v); CHECK(v[0]==GL_INVERT);
+    glGetIntegerv(GL_STENCIL_BACK_WRITEMASK,v); CHECK(v[0]==0x0F);
+    GLfloat a[4]; glGetVertexAttribfv(2,GL_CURRENT_VERTEX_ATTRIB,a); CHECK(a[0]==0.5f && a[1]==0.25f);
+    if(gl){
+        CHECK(glIsEnabled(GLSTATE_FRAMEBUFFER_SRGB));
+        glGetIntegerv(GLSTATE_POLYGON_MODE,v); CHECK(v[0]==0x1B01);
+    }
+    CHECK(glGetError()==GL_NO_ERROR);
+
+    // The C ABI as another library finds it: read side only, size = bytes filled
+    CHECK(!dlsym(RTLD_DEFAULT,"motionblur_init") && !dlsym(RTLD_DEFAULT,"motionblur_process") && !dlsym(RTLD_DEFAULT,"motionblur_set"));
+    auto frame=(int(*)(MotionBlurFrame*))dlsym(RTLD_DEFAULT,"motionblur_frame");
+    CHECK(frame);
+    struct { MotionBlurFrame f; char newer[16]; } big={{sizeof(big)}};
+    CHECK(frame(&big.f) && big.f.size==sizeof(MotionBlurFrame) && big.f.frame>0 && big.f.capture);
+    MotionBlurFrame older={2*sizeof(unsigned)};
+    CHECK(frame(&older) && older.size==2*sizeof(unsigned) && older.frame>0 && !older.capture);
+    printf("preload %s: %s, bar %d trail %d, state kept\n",gl?"gl":"es",(const char*)glGetString(GL_VERSION),bar.r,trail.r);
+    return 0;
+}
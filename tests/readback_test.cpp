@@ -0,0 +1,40 @@
+// Readback of a multisampled surface on llvmpipe: bindReadable() resolves it
+// into a single-sample target, so glReadPixels never reads a multisampled
+// framebuffer (Mesa tolerates that on the default one, not every driver does).
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "Pipeline.h"
+
+static const int W=64, H=48;
+
+int main(){
+    HeadlessGL gl; EGLint ms[]={EGL_SAMPLES,4,EGL_NONE};
+    if(!gl.open(W,H,ms)) return SKIP;
+    if(gl.attrib(EGL_SAMPLES)<=1){ fprintf(stderr,"skipped: no multisampled pbuffer\n"); return SKIP; }
+    surf={gl.srf,gl.attrib(EGL_SAMPLES),GL_RGBA8,0};
+
+    glBindFramebuffer(GL_FRAMEBUFFER,0); glClearColor(0,1,0,1); glClear(GL_COLOR_BUFFER_BIT);
+    GLint sb=0; glGetIntegerv(GL_SAMPLE_BUFFERS,&sb);
+    CHECK(sb==1);   // what recordFrame used to read
+
+    glEnable(GL_SCISSOR_TEST); glScissor(0,0,1,1);   // the resolve covers the whole surface anyway
+    bindReadable(W,H);
+    Pixel a=readPixel(W-2,H-2);
+    CHECK(glGetError()==GL_NO_ERROR && a.g==255 && a.r==0);
+    GLint rfb=0; glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING,&rfb);
+    CHECK(rfb!=0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER,rfb); glGetIntegerv(GL_SAMPLE_BUFFERS,&sb);
+    CHECK(sb==0);
+    CHECK(glIsEnabled(GL_SCISSOR_TEST));
+
+    // A new size gets a new target
+    bindReadable(W/2,H/2);
+    CHECK(glGetError()==GL_NO_ERROR && readPixel(W/2-1,H/2-1).g==255);
+
+    // Single-sample surfaces are read in place
+    surf.samples=1; bindReadable(W,H);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING,&rfb);
+    CHECK(rfb==0);
+    printf("readback: %d samples resolved, pixel %d,%d,%d\n",gl.attrib(EGL_SAMPLES),a.r,a.g,a.b);
+    return 0;
+}
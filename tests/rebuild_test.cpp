@@ -0,0 +1,51 @@
+// Setting changes on llvmpipe (governor steps): sharpen on/off recompiles only
+// the draw pass, and a real rebuild (scale) starts the history from the capture,
+// so the first frame after it is not faded towards black. Governor steps come
+// and go all session long, so rebuilds must not leave buffers or shaders behind.
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "Pipeline.h"
+#include "Config.h"
+
+static const int W=128, H=128;
+
+static Pixel frames(int n){
+    for(int f=0;f<n;f++){
+        glBindFramebuffer(GL_FRAMEBUFFER,0); glClearColor(0.6f,0.6f,0.6f,1); glClear(GL_COLOR_BUFFER_BIT);
+        render(W,H,false);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,0);
+    return readPixel(W/2,H/2);
+}
+
+// Live GL names of one kind (Mesa hands out low, increasing names)
+static int live(GLboolean (*is)(GLuint)){ int n=0; for(GLuint i=1;i<4096;i++) n+=is(i); return n; }
+
+int main(){
+    HeadlessGL gl;
+    if(!gl.open(W,H)) return SKIP;
+    Config c; c.maskShape=MASK_NONE; c.sharpen=0.5f; c.scale=0.5f; config.store(c);
+    Pixel settled=frames(30);
+    GLuint t0=frameTextures().capture;   // compared two frames on: the same ring slot
+
+    // Level 1: no sharpening, same textures
+    governorLevel=1;
+    Pixel p=frames(2);
+    CHECK(cfg.sharpen==0 && frameTextures().capture==t0);
+    CHECK(abs(p.r-settled.r)<=2);
+
+    // Level 2: scale 0.35 needs new textures; the history is seeded, not black
+    governorLevel=2;
+    p=frames(1);
+    CHECK(abs(p.r-settled.r)<=2);
+    frames(1);
+    CHECK(cfg.scale==0.35f && frameTextures().capture!=t0);
+    CHECK(glGetError()==GL_NO_ERROR);
+
+    // Level 3 and back: two more full rebuilds, nothing left over
+    int buffers=live(glIsBuffer), shaders=live(glIsShader);
+    for(int l:{3,2,3,2}){ governorLevel=l; frames(1); }
+    CHECK(live(glIsBuffer)==buffers && live(glIsShader)==shaders);
+    printf("rebuild: settled %d, after the sharpen step %d, first frame after the scale step %d\n",settled.r,frames(0).r,p.r);
+    return 0;
+}
@@ -0,0 +1,93 @@
+// GAME_SCALE path on llvmpipe, through the hook entry points (Redirect.h) the way
+// the game reaches them: it binds framebuffer 0 and sets surface-sized rectangles,
+// render() captures from gameFBO at half the surface size and the draw pass
+// upscales onto the surface. Left half red, right half blue must come out graded
+// (ACES maps 1.0 to ~0.80) on the matching halves of the full-size surface, and
+// nothing the default framebuffer held before the present may leak into the
+// output. The game's own view must stay surface-sized: a get/set round trip of
+// the viewport and binding (what ImGui's GL backend does around its draws) keeps
+// the redirect, and reads from framebuffer 0 see its whole picture.
+#include <cstring>
+
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "Pipeline.h"
+#include "Redirect.h"
+
+static const int W=256, H=128;
+
+// One frame of the "game": both halves cleared through scissor rectangles
+static void drawGame(){
+    // Stale surface content: the redirected game never touches framebuffer 0
+    glBindFramebuffer(GL_FRAMEBUFFER,0); glViewport(0,0,W,H); glClearColor(0,1,0,1); glClear(GL_COLOR_BUFFER_BIT);
+    hBindFramebuffer(GL_FRAMEBUFFER,0); hViewport(0,0,W,H); glEnable(GL_SCISSOR_TEST);
+    hScissor(0,0,W/2,H); glClearColor(1,0,0,1); glClear(GL_COLOR_BUFFER_BIT);
+    hScissor(W/2,0,W-W/2,H); glClearColor(0,0,1,1); glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void present(){
+    inHook=true; render(W,H,false); inHook=false;
+    redirectRebind();   // as finish() does
+}
+
+int main(){
+    HeadlessGL gl;
+    if(!gl.open(W,H)) return SKIP;
+    oBindFramebuffer=glBindFramebuffer; oViewport=glViewport; oScissor=glScissor; oBlitFramebuffer=glBlitFramebuffer;
+    oInvalidateFramebuffer=glInvalidateFramebuffer; oGetIntegerv=glGetIntegerv; oGetIntegeri_v=glGetIntegeri_v;
+    oReadPixels=glReadPixels; oCopyTexImage2D=glCopyTexImage2D; oCopyTexSubImage2D=glCopyTexSubImage2D; oCopyTexSubImage3D=glCopyTexSubImage3D;
+    redirect=true; gameScale=0.5f;
+    drawGame(); present();   // first present builds gameFBO
+    CHECK(gameFBO && gW==W/2 && gH==H/2);
+
+    GLint v[4], b=-1, real[4], rb=0;
+    for(int f=0;f<60;f++){
+        drawGame();
+        // Save, draw elsewhere, restore: what came back must still be redirected
+        hGetIntegerv(GL_VIEWPORT,v); hGetIntegerv(GL_FRAMEBUFFER_BINDING,&b);
+        if(f==0) CHECK(v[0]==0 && v[1]==0 && v[2]==W && v[3]==H && b==0);
+        hViewport(0,0,16,16); hViewport(v[0],v[1],v[2],v[3]); hBindFramebuffer(GL_FRAMEBUFFER,(GLuint)b);
+        if(f==0){
+            glGetIntegerv(GL_VIEWPORT,real); glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING,&rb);
+            CHECK(real[2]==gW && real[3]==gH && rb==(GLint)gameFBO);
+        }
+        present();
+    }
+    CHECK(glGetError()==GL_NO_ERROR);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,0);
+    Pixel l=readPixel(W/4,H/2), r=readPixel(3*W/4,H/2), c=readPixel(W/2+8,H-2);
+    CHECK_NEAR(l.r,205,6); CHECK(l.g<4 && l.b<4);
+    CHECK_NEAR(r.b,205,6); CHECK(r.r<4 && r.g<4);
+    CHECK(c.g<4);
+    redirectRebind();
+
+    // Reads of framebuffer 0 return the game's picture at surface size, scissor or not
+    drawGame();
+    glEnable(GL_SCISSOR_TEST); hScissor(0,0,1,1);
+    unsigned char row[W*4]={};
+    hReadPixels(0,H/2,W,1,GL_RGBA,GL_UNSIGNED_BYTE,row);
+    CHECK(row[4*4]==255 && row[4*4+2]==0 && row[4*(W-4)]==0 && row[4*(W-4)+2]==255);
+    GLuint tex[2], fb; glGenTextures(2,tex); glGenFramebuffers(1,&fb);
+    glBindTexture(GL_TEXTURE_2D,tex[0]); glTexStorage2D(GL_TEXTURE_2D,1,GL_RGBA8,W,H);
+    hCopyTexSubImage2D(GL_TEXTURE_2D,0,0,0,0,0,W,H);
+    glBindTexture(GL_TEXTURE_2D,tex[1]); hCopyTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,W/2,0,W/2,H,0);
+    CHECK(glIsEnabled(GL_SCISSOR_TEST));
+    glDisable(GL_SCISSOR_TEST);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING,&rb); CHECK(rb==(GLint)gameFBO);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING,&rb); CHECK(rb==(GLint)gameFBO);
+    hGetIntegerv(GL_READ_FRAMEBUFFER_BINDING,&b); CHECK(b==0);
+    hGetIntegerv(GL_SCISSOR_BOX,v); CHECK(v[2]==1 && v[3]==1);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,fb);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,tex[0],0);
+    Pixel cl=readPixel(W/4,H/2), cr=readPixel(3*W/4,H-1);
+    CHECK(cl.r==255 && cl.b==0 && cr.r==0 && cr.b==255);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,tex[1],0);
+    Pixel ci=readPixel(W/4,0);
+    CHECK(ci.r==0 && ci.b==255);
+    CHECK(glGetError()==GL_NO_ERROR);
+    printf("redirect %dx%d -> %dx%d: left (%d,%d,%d) right (%d,%d,%d), reads of framebuffer 0 at surface size\n",gW,gH,W,H,l.r,l.g,l.b,r.r,r.g,r.b);
+    return 0;
+}
@@ -0,0 +1,69 @@
+// The standalone library (MotionBlur.cpp built with MOTIONBLUR_STANDALONE) driven
+// through its C ABI the way a host app would: init, resize, process into an FBO of
+// its own. A plain RGBA8 texture input is blitted; a multisampled RGB10_A2 input
+// must be resolved in its own format, which only works if process() picked up the
+// new input's samples and format (a resolve between formats is a GL error).
+#include "Check.h"
+#include "HeadlessGL.h"
+#include "MotionBlurApi.h"
+
+static const int W=128, H=96;
+
+static GLuint target(GLuint tex){
+    GLuint fb; glGenFramebuffers(1,&fb); glBindFramebuffer(GL_FRAMEBUFFER,fb);
+    glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,tex,0);
+    return fb;
+}
+
+// Left half red, right half blue
+static void fill(GLuint fb){
+    glBindFramebuffer(GL_FRAMEBUFFER,fb); glEnable(GL_SCISSOR_TEST);
+    glScissor(0,0,W/2,H); glClearColor(1,0,0,1); glClear(GL_COLOR_BUFFER_BIT);
+    glScissor(W/2,0,W-W/2,H); glClearColor(0,0,1,1); glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+int main(){
+    HeadlessGL gl;
+    if(!gl.open(W,H)) return SKIP;
+    CHECK(motionblur_api_version()==MOTIONBLUR_API_VERSION);
+    CHECK(motionblur_init(0,0));
+    motionblur_resize(W,H);
+    CHECK(motionblur_set("mask=none sharpen=0") && !motionblur_set("mask=none bogus=1") && !motionblur_set(0));
+
+    GLuint tex[2]; glGenTextures(2,tex);
+    for(GLuint t:tex){ glBindTexture(GL_TEXTURE_2D,t); glTexStorage2D(GL_TEXTURE_2D,1,GL_RGBA8,W,H); }
+    GLuint in=target(tex[0]), out=target(tex[1]);
+    MotionBlurStats st={sizeof(st)}; MotionBlurFrame fr={sizeof(fr)};
+
+    // Texture input, single-sampled: blit capture, graded halves in the output
+    for(int f=0;f<30;f++){ fill(in); motionblur_process_texture(tex[0],out); }
+    CHECK(glGetError()==GL_NO_ERROR);
+    CHECK(motionblur_stats(&st) && st.width==W && st.height==H && st.capture==0);
+    CHECK(motionblur_frame(&fr) && fr.frame>=30 && fr.capture);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,out);
+    Pixel l=readPixel(W/4,H/2), r=readPixel(3*W/4,H/2);
+    CHECK_NEAR(l.r,205,6); CHECK(l.b<4); CHECK_NEAR(r.b,205,6); CHECK(r.r<4);
+
+    // Multisampled RGB10_A2 renderbuffer: resolved, not blitted
+    GLint maxSamples=0; glGetIntegerv(GL_MAX_SAMPLES,&maxSamples);
+    if(maxSamples>=4){
+        GLuint rb, ms; glGenRenderbuffers(1,&rb); glBindRenderbuffer(GL_RENDERBUFFER,rb);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER,4,GL_RGB10_A2,W,H);
+        glGenFramebuffers(1,&ms); glBindFramebuffer(GL_FRAMEBUFFER,ms);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_RENDERBUFFER,rb);
+        CHECK(glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE);
+        for(int f=0;f<30;f++){ fill(ms); motionblur_process(ms,out,0); }
+        CHECK(glGetError()==GL_NO_ERROR);
+        CHECK(motionblur_stats(&st) && st.capture!=0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER,out);
+        l=readPixel(W/4,H/2), r=readPixel(3*W/4,H/2);
+        CHECK_NEAR(l.r,205,8); CHECK(l.b<4); CHECK_NEAR(r.b,205,8); CHECK(r.r<4);
+    }
+
+    // Back to the texture: single-sampled again
+    for(int f=0;f<4;f++){ fill(in); motionblur_process(in,out,0); }
+    CHECK(glGetError()==GL_NO_ERROR && motionblur_stats(&st) && st.capture==0);
+    printf("standalone: %u frames, left (%d,%d,%d) right (%d,%d,%d)%s\n",st.frame,l.r,l.g,l.b,r.r,r.g,r.b,maxSamples>=4?", multisampled RGB10_A2 input resolved":"");
+    return 0;
+}
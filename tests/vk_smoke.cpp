@@ -0,0 +1,164 @@
+// VK_LAYER_MOTIONBLUR under VK_LAYER_KHRONOS_validation: a headless surface
+// (VK_EXT_headless_surface, lavapipe has it), one swapchain per UNORM and sRGB
+// format the surface offers, a few cleared frames presented through the layer
+// each, and a config reload in between so the internal images are rebuilt.
+// Any validation error fails the run. ctest points VK_ADD_LAYER_PATH at the
+// build directory; VK_SMOKE_REQUIRED=1 (CI) turns a missing driver into a failure.
+#include <vulkan/vulkan.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Check.h"
+
+static const char* LAYERS[]={"VK_LAYER_MOTIONBLUR","VK_LAYER_KHRONOS_validation"};   // ours first: validation checks what it emits
+static const VkFormat FORMATS[]={VK_FORMAT_B8G8R8A8_UNORM,VK_FORMAT_B8G8R8A8_SRGB,VK_FORMAT_R8G8B8A8_UNORM,VK_FORMAT_R8G8B8A8_SRGB};
+static const int FRAMES=6;
+
+static int errors=0;
+static VKAPI_ATTR VkBool32 VKAPI_CALL onMessage(VkDebugUtilsMessageSeverityFlagBitsEXT sev, VkDebugUtilsMessageTypeFlagsEXT,
+                                                const VkDebugUtilsMessengerCallbackDataEXT* m, void*){
+    bool err=sev>=VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    fprintf(stderr,"%s: %s\n",err?"error":"warning",m->pMessage);
+    errors+=err;
+    return VK_FALSE;
+}
+
+static int skip(const char* why){ fprintf(stderr,"vk_smoke: %s\n",why); return getenv("VK_SMOKE_REQUIRED")?1:SKIP; }
+
+static bool hasLayer(const char* name){
+    uint32_t n=0; vkEnumerateInstanceLayerProperties(&n,0);
+    std::vector<VkLayerProperties> l(n); vkEnumerateInstanceLayerProperties(&n,l.data());
+    for(auto& p:l) if(!strcmp(p.layerName,name)) return true;
+    return false;
+}
+
+static void writeConfig(const char* path, float scale){
+    FILE* f=fopen(path,"w");
+    fprintf(f,"scale=%g\nsharpen=0.5\nmask=circle\n",scale);
+    fclose(f);
+}
+
+struct Frame { VkDevice dev; VkQueue q; VkCommandBuffer cb; VkSemaphore acquired, drawn; };
+
+// One app frame: acquire, clear, present. The queue drains after each, so the
+// semaphores are free again for the next.
+static bool present(Frame& f, VkSwapchainKHR sc, const std::vector<VkImage>& images, float v){
+    uint32_t i;
+    if(vkAcquireNextImageKHR(f.dev,sc,UINT64_MAX,f.acquired,VK_NULL_HANDLE,&i)!=VK_SUCCESS) return false;
+    vkResetCommandBuffer(f.cb,0);
+    VkCommandBufferBeginInfo bi={VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    vkBeginCommandBuffer(f.cb,&bi);
+    VkImageSubresourceRange all={VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1};
+    VkImageMemoryBarrier b={VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,0,0,VK_ACCESS_TRANSFER_WRITE_BIT,VK_IMAGE_LAYOUT_UNDEFINED,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,VK_QUEUE_FAMILY_IGNORED,VK_QUEUE_FAMILY_IGNORED,images[i],all};
+    vkCmdPipelineBarrier(f.cb,VK_PIPELINE_STAGE_TRANSFER_BIT,VK_PIPELINE_STAGE_TRANSFER_BIT,0,0,0,0,0,1,&b);
+    VkClearColorValue c={{v,0.5f,1-v,1}};
+    vkCmdClearColorImage(f.cb,images[i],VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,&c,1,&all);
+    b.srcAccessMask=VK_ACCESS_TRANSFER_WRITE_BIT; b.dstAccessMask=0;
+    b.oldLayout=VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL; b.newLayout=VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    vkCmdPipelineBarrier(f.cb,VK_PIPELINE_STAGE_TRANSFER_BIT,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,0,0,0,0,0,1,&b);
+    vkEndCommandBuffer(f.cb);
+    VkPipelineStageFlags stage=VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkSubmitInfo si={VK_STRUCTURE_TYPE_SUBMIT_INFO,0,1,&f.acquired,&stage,1,&f.cb,1,&f.drawn};
+    if(vkQueueSubmit(f.q,1,&si,VK_NULL_HANDLE)!=VK_SUCCESS) return false;
+    VkPresentInfoKHR pi={VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,0,1,&f.drawn,1,&sc,&i};
+    VkResult r=vkQueuePresentKHR(f.q,&pi);
+    vkQueueWaitIdle(f.q);
+    return r==VK_SUCCESS || r==VK_SUBOPTIMAL_KHR;
+}
+
+int main(){
+    char cfg[]="/tmp/vk_smoke_XXXXXX";
+    int fd=mkstemp(cfg); if(fd<0) return 1; close(fd);
+    writeConfig(cfg,0.5f);
+    setenv("MOTIONBLUR_CONFIG",cfg,1);   // read by the layer's watcher once it is loaded
+
+    CHECK(hasLayer(LAYERS[0]));
+    if(!hasLayer(LAYERS[1])) return skip("no VK_LAYER_KHRONOS_validation");
+    const char* ext[]={VK_KHR_SURFACE_EXTENSION_NAME,VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME,VK_EXT_DEBUG_UTILS_EXTENSION_NAME};
+    VkDebugUtilsMessengerCreateInfoEXT mi={VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT};
+    mi.messageSeverity=VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT|VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    mi.messageType=VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT|VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+    mi.pfnUserCallback=onMessage;
+    VkApplicationInfo app={VK_STRUCTURE_TYPE_APPLICATION_INFO,0,"vk_smoke",1,0,0,VK_API_VERSION_1_1};
+    VkInstanceCreateInfo ici={VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,&mi,0,&app,2,LAYERS,3,ext};
+    VkInstance inst;
+    if(vkCreateInstance(&ici,0,&inst)!=VK_SUCCESS) return skip("no instance with headless surfaces");
+    auto makeMessenger=(PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(inst,"vkCreateDebugUtilsMessengerEXT");
+    auto freeMessenger=(PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(inst,"vkDestroyDebugUtilsMessengerEXT");
+    auto makeSurface=(PFN_vkCreateHeadlessSurfaceEXT)vkGetInstanceProcAddr(inst,"vkCreateHeadlessSurfaceEXT");
+    VkDebugUtilsMessengerEXT msg; CHECK(makeMessenger(inst,&mi,0,&msg)==VK_SUCCESS);
+    VkHeadlessSurfaceCreateInfoEXT hi={VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT};
+    VkSurfaceKHR surf; CHECK(makeSurface(inst,&hi,0,&surf)==VK_SUCCESS);
+
+    // A queue the layer can run on: graphics + compute, presenting to the surface
+    uint32_t n=0; vkEnumeratePhysicalDevices(inst,&n,0);
+    std::vector<VkPhysicalDevice> gpus(n); vkEnumeratePhysicalDevices(inst,&n,gpus.data());
+    VkPhysicalDevice gpu=VK_NULL_HANDLE; uint32_t fam=0;
+    for(VkPhysicalDevice g:gpus){
+        uint32_t nf=0; vkGetPhysicalDeviceQueueFamilyProperties(g,&nf,0);
+        std::vector<VkQueueFamilyProperties> fp(nf); vkGetPhysicalDeviceQueueFamilyProperties(g,&nf,fp.data());
+        for(uint32_t i=0;i<nf && !gpu;i++){
+            VkBool32 ok=VK_FALSE; vkGetPhysicalDeviceSurfaceSupportKHR(g,i,surf,&ok);
+            if(ok && (fp[i].queueFlags&(VK_QUEUE_GRAPHICS_BIT|VK_QUEUE_COMPUTE_BIT))==(VK_QUEUE_GRAPHICS_BIT|VK_QUEUE_COMPUTE_BIT)){ gpu=g; fam=i; }
+        }
+    }
+    if(!gpu) return skip("no device presents to a headless surface");
+    float prio=1;
+    VkDeviceQueueCreateInfo qi={VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,0,0,fam,1,&prio};
+    const char* dext[]={VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    VkDeviceCreateInfo dci={VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,0,0,1,&qi,0,0,1,dext};
+    Frame f={};
+    CHECK(vkCreateDevice(gpu,&dci,0,&f.dev)==VK_SUCCESS);
+    vkGetDeviceQueue(f.dev,fam,0,&f.q);
+    VkCommandPoolCreateInfo pci={VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,0,VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,fam};
+    VkCommandPool pool; CHECK(vkCreateCommandPool(f.dev,&pci,0,&pool)==VK_SUCCESS);
+    VkCommandBufferAllocateInfo cai={VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,0,pool,VK_COMMAND_BUFFER_LEVEL_PRIMARY,1};
+    CHECK(vkAllocateCommandBuffers(f.dev,&cai,&f.cb)==VK_SUCCESS);
+    VkSemaphoreCreateInfo sci={VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    vkCreateSemaphore(f.dev,&sci,0,&f.acquired); vkCreateSemaphore(f.dev,&sci,0,&f.drawn);
+
+    VkSurfaceCapabilitiesKHR caps; vkGetPhysicalDeviceSurfaceCapabilitiesKHR(gpu,surf,&caps);
+    CHECK(caps.supportedUsageFlags&VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    CHECK(caps.supportedUsageFlags&VK_IMAGE_USAGE_TRANSFER_SRC_BIT);   // or the layer passes the swapchains through
+    uint32_t nfmt=0; vkGetPhysicalDeviceSurfaceFormatsKHR(gpu,surf,&nfmt,0);
+    std::vector<VkSurfaceFormatKHR> offered(nfmt); vkGetPhysicalDeviceSurfaceFormatsKHR(gpu,surf,&nfmt,offered.data());
+    int tested=0, srgb=0;
+    for(VkFormat want:FORMATS){
+        const VkSurfaceFormatKHR* sf=0;
+        for(auto& o:offered) if(o.format==want) sf=&o;
+        if(!sf) continue;
+        VkSwapchainCreateInfoKHR ci={VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
+        ci.surface=surf; ci.minImageCount=caps.maxImageCount?std::min(caps.minImageCount+1,caps.maxImageCount):caps.minImageCount+1;
+        ci.imageFormat=sf->format; ci.imageColorSpace=sf->colorSpace;
+        ci.imageExtent=caps.currentExtent.width!=~0u?caps.currentExtent:VkExtent2D{320,200};
+        ci.imageArrayLayers=1; ci.imageUsage=VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        ci.preTransform=caps.currentTransform; ci.presentMode=VK_PRESENT_MODE_FIFO_KHR; ci.clipped=VK_TRUE;
+        ci.compositeAlpha=(caps.supportedCompositeAlpha&VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)?VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR
+                         :(VkCompositeAlphaFlagBitsKHR)(caps.supportedCompositeAlpha&-caps.supportedCompositeAlpha);
+        VkSwapchainKHR sc; CHECK(vkCreateSwapchainKHR(f.dev,&ci,0,&sc)==VK_SUCCESS);
+        uint32_t ni=0; vkGetSwapchainImagesKHR(f.dev,sc,&ni,0);
+        std::vector<VkImage> images(ni); vkGetSwapchainImagesKHR(f.dev,sc,&ni,images.data());
+        for(int k=0;k<FRAMES;k++) CHECK(present(f,sc,images,k/(float)FRAMES));
+        // A new scale: the layer waits for its frames and rebuilds the internal images on the next present
+        sleep(1); writeConfig(cfg,tested%2?0.5f:0.75f); sleep(2);   // file times are in seconds
+        for(int k=0;k<FRAMES;k++) CHECK(present(f,sc,images,k/(float)FRAMES));
+        vkDestroySwapchainKHR(f.dev,sc,0);
+        tested++; srgb+=want==VK_FORMAT_B8G8R8A8_SRGB || want==VK_FORMAT_R8G8B8A8_SRGB;
+    }
+
+    vkDestroySemaphore(f.dev,f.acquired,0); vkDestroySemaphore(f.dev,f.drawn,0);
+    vkDestroyCommandPool(f.dev,pool,0);
+    vkDestroyDevice(f.dev,0);
+    vkDestroySurfaceKHR(inst,surf,0);
+    freeMessenger(inst,msg,0);
+    vkDestroyInstance(inst,0);
+    unlink(cfg);
+    CHECK(tested>0);
+    CHECK(errors==0);
+    printf("vk_smoke: %d swapchains (%d sRGB), %d presents each, no validation errors\n",tested,srgb,2*FRAMES);
+    return 0;
+}
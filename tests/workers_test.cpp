@@ -0,0 +1,69 @@
+// Worker pool and recorder under churn, also built with -fsanitize=thread as
+// workers_tsan. Waves of short-lived threads, many more than there are lanes
+// over the run, each post a burst and exit: every item must run, so lanes have
+// to come back when their threads go. Then the recorder with the posting
+// thread's urgent lane full: the drain can't be queued by the push, and
+// recordKick() has to get the copy (and the close behind it) done.
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <atomic>
+#include <cstring>
+
+#include "Check.h"
+#include "Workers.h"
+#include "Recorder.h"
+
+static const int WAVES = 24, PER_WAVE = 6, ITEMS = 500;   // 144 threads over the run, 8 lanes
+
+static std::atomic<int> ran{0};
+static void count(void*){ ran.fetch_add(1,std::memory_order_relaxed); }
+
+static double now(){ timespec t; clock_gettime(CLOCK_MONOTONIC,&t); return t.tv_sec+t.tv_nsec*1e-9; }
+
+// Posts ITEMS, spinning while the lane is full; gives up after a second of refusals
+static void* poster(void* failed){
+    for(int i=0;i<ITEMS;i++){
+        double t0=now();
+        while(!workPost(count,0,(WorkPriority)(i%WORK_PRIORITIES))){
+            if(now()-t0>1){ ((std::atomic<int>*)failed)->fetch_add(1); return 0; }
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+// Holds a worker until released
+static std::atomic<bool> hold{true};
+static std::atomic<int> held{0};
+static void block(void*){ held.fetch_add(1); while(hold.load()) sched_yield(); }
+
+int main(){
+    workersStart();
+    std::atomic<int> failed{0};
+    for(int w=0;w<WAVES;w++){
+        pthread_t t[PER_WAVE];
+        for(auto& x:t) CHECK(pthread_create(&x,0,poster,&failed)==0);
+        for(auto& x:t) pthread_join(x,0);
+    }
+    CHECK(failed.load()==0);
+    for(double t0=now();ran.load()<WAVES*PER_WAVE*ITEMS && now()-t0<10;) sched_yield();
+    CHECK(ran.load()==WAVES*PER_WAVE*ITEMS);
+
+    // Recorder: both workers held, then this thread's urgent lane filled to the brim
+    recorderInit("/tmp");
+    CHECK(workPost(block,0,WORK_URGENT) && workPost(block,0,WORK_URGENT));
+    while(held.load()<2) sched_yield();
+    int filler=0; while(workPost(count,0,WORK_URGENT)) filler++;
+    uint8_t src[64], dst[64]={}; for(int i=0;i<64;i++) src[i]=(uint8_t)i;
+    std::atomic<bool> done{false};
+    RecordJob copy={RecordJob::COPY,0,0,0,0,src,&done,dst,sizeof(src)};
+    CHECK(recordPush(copy));            // queued, its drain not
+    CHECK(recordPush({RecordJob::CLOSE}));
+    hold.store(false);
+    double t0=now();
+    while(!done.load(std::memory_order_acquire) && now()-t0<5){ recordKick(); sched_yield(); }
+    CHECK(done.load() && !memcmp(src,dst,sizeof(src)));
+    printf("workers: %d items from %d threads, recorder drained after %d-item backlog\n",ran.load(),WAVES*PER_WAVE,filler);
+    return 0;
+}
@@ -0,0 +1,121 @@
+// mbreplay: runs a frame dump (see src/FrameDump.h) through the pipeline on a
+// headless EGL context and reports how long each frame took.
+// usage: mbreplay dump.mbfd [loops] ["k=v k=v" settings on top of the dump's]
+// Each stored frame is scaled back up to the surface size it was captured at
+// and processed with its own damage and mask flag, on a surface with the
+// device's sample count and colour format and, if the game was redirected,
+// through the same reduced game target, so the GPU sees the same amount of
+// work and the same capture path as on the device (the picture is only as
+// sharp as the dump).
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "FrameDump.h"
+#include "Histogram.h"
+#include "Pipeline.h"
+#include "Telemetry.h"
+
+int main(int argc, char** argv){
+    if(argc<2){ fprintf(stderr,"usage: %s dump.mbfd [loops] [\"k=v ...\"]\n",argv[0]); return 1; }
+    int loops=argc>2?atoi(argv[2]):1;
+    int fd=open(argv[1],O_RDONLY); struct stat st;
+    if(fd<0 || fstat(fd,&st)<0){ perror(argv[1]); return 1; }
+    void* p=st.st_size>=(off_t)sizeof(DumpHeader) ? mmap(0,st.st_size,PROT_READ,MAP_PRIVATE,fd,0) : MAP_FAILED;
+    close(fd);
+    const DumpHeader* d=(const DumpHeader*)p;
+    if(p==MAP_FAILED || memcmp(d->magic,"MBFD",4) || d->version!=DUMP_VERSION || !d->slots || (size_t)st.st_size<dumpBytes(d->slots,d->slotBytes)){
+        fprintf(stderr,"%s: not a version %u frame dump\n",argv[1],DUMP_VERSION); return 1;
+    }
+    uint32_t count=d->written<d->slots?d->written:d->slots, first=d->written-count;
+    if(!count){ fprintf(stderr,"%s: no frames\n",argv[1]); return 1; }
+
+    // Settings: the dump's, then the command line's
+    Config c;
+    applyKeys(c,d->config);
+    if(argc>3 && !applyKeys(c,argv[3])){ fprintf(stderr,"bad settings: %s\n",argv[3]); return 1; }
+    config.store(c);
+
+    int W=1, H=1;
+    for(uint32_t i=first;i!=d->written;i++){
+        const DumpFrame* f=dumpSlot(d,i);
+        int w=f->turns&1?f->h:f->w, h=f->turns&1?f->w:f->h;   // the output pass writes the turned size
+        W=f->w>W?f->w:W; H=f->h>H?f->h:H; W=w>W?w:W; H=h>H?h:H;
+    }
+
+    // Headless context: Mesa's surfaceless platform, a pbuffer standing in for the
+    // window, with the device surface's samples and channel sizes
+    auto platform=(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay dpy=platform?platform(EGL_PLATFORM_SURFACELESS_MESA,EGL_DEFAULT_DISPLAY,0):eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint n=0; EGLConfig cf;
+    EGLint bits[4]={8,8,8,8};   // r, g, b, a
+    if(d->fmt==GL_RGB565){ bits[0]=5; bits[1]=6; bits[2]=5; bits[3]=0; } else if(d->fmt==GL_RGB10_A2){ bits[0]=bits[1]=bits[2]=10; bits[3]=2; } else if(d->fmt==GL_RGB8) bits[3]=0;
+    EGLint ca[]={EGL_RENDERABLE_TYPE,EGL_OPENGL_ES3_BIT,EGL_SURFACE_TYPE,EGL_PBUFFER_BIT,EGL_RED_SIZE,bits[0],EGL_GREEN_SIZE,bits[1],EGL_BLUE_SIZE,bits[2],EGL_ALPHA_SIZE,bits[3],
+                 EGL_SAMPLES,d->samples>1?(EGLint)d->samples:0,EGL_NONE};
+    EGLint xa[]={EGL_CONTEXT_MAJOR_VERSION,3,EGL_NONE}, pa[]={EGL_WIDTH,W,EGL_HEIGHT,H,EGL_NONE};
+    if(!eglInitialize(dpy,0,0) || !eglBindAPI(EGL_OPENGL_ES_API) || !eglChooseConfig(dpy,ca,&cf,1,&n) || !n){
+        fprintf(stderr,"no GLES3 pbuffer config with %u samples, format 0x%x\n",d->samples,d->fmt); return 1;
+    }
+    EGLContext ctx=eglCreateContext(dpy,cf,EGL_NO_CONTEXT,xa);
+    EGLSurface srf=eglCreatePbufferSurface(dpy,cf,pa);
+    if(!ctx || !srf || !eglMakeCurrent(dpy,srf,srf,ctx)){ fprintf(stderr,"can't create a %dx%d GLES3 pbuffer\n",W,H); return 1; }
+    EGLint got=0; eglGetConfigAttrib(dpy,cf,EGL_SAMPLES,&got);
+    surf={srf,got>1?got:1,(GLenum)d->fmt,0};
+    redirect=d->redirect!=0; gameScale=d->gameScale;
+    printf("%s: %u frames, %s, %d samples, format 0x%x%s\n%s\n",argv[1],count,(const char*)glGetString(GL_RENDERER),surf.samples,surf.fmt,
+        redirect?", redirected":"",d->config);
+
+    // Upload: a textured draw, since a multisampled surface can't be blitted into
+    GLuint tex;
+    glGenTextures(1,&tex); glBindTexture(GL_TEXTURE_2D,tex); glTexStorage2D(GL_TEXTURE_2D,1,GL_RGBA8,d->maxSize,d->maxSize);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR); glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    const char* vs="#version 300 es\nuniform vec2 k; out vec2 uv;\n"
+        "void main(){ vec2 p=vec2(gl_VertexID&1,gl_VertexID>>1); uv=p*k; gl_Position=vec4(p*2.0-1.0,0,1); }";
+    const char* fs="#version 300 es\nprecision mediump float; uniform sampler2D t; in vec2 uv; out vec4 o;\nvoid main(){ o=texture(t,uv); }";
+    GLuint prog=glCreateProgram();
+    for(int i=0;i<2;i++){ GLuint sh=glCreateShader(i?GL_FRAGMENT_SHADER:GL_VERTEX_SHADER); glShaderSource(sh,1,i?&fs:&vs,0); glCompileShader(sh); glAttachShader(prog,sh); glDeleteShader(sh); }
+    glLinkProgram(prog);
+    GLint linked=0; glGetProgramiv(prog,GL_LINK_STATUS,&linked);
+    if(!linked){ fprintf(stderr,"upload shader failed\n"); return 1; }
+    GLuint vao; glGenVertexArrays(1,&vao);
+
+    Histogram total, upload; uint64_t spent=0;
+    for(int l=0;l<loops;l++) for(uint32_t i=first;i!=d->written;i++){
+        const DumpFrame* f=dumpSlot(d,i);
+        Rect r={f->damage[0],f->damage[1],f->damage[2],f->damage[3]};
+        turns=f->turns;
+        if(f->w!=sW || f->h!=sH) render(f->w,f->h,f->mask!=0,&r);   // (re)builds gameFBO before the game draws into it
+        uint64_t t0=traceNow();
+        glBindTexture(GL_TEXTURE_2D,tex);
+        glTexSubImage2D(GL_TEXTURE_2D,0,0,0,f->pw,f->ph,GL_RGBA,GL_UNSIGNED_BYTE,dumpPixels(f));
+        glBindFramebuffer(GL_FRAMEBUFFER,redirect?gameFBO:0);
+        glViewport(0,0,redirect?gW:f->w,redirect?gH:f->h);
+        glDisable(GL_SCISSOR_TEST); glDisable(GL_STENCIL_TEST); glDisable(GL_BLEND); glDisable(GL_DEPTH_TEST);
+        glUseProgram(prog); glUniform2f(glGetUniformLocation(prog,"k"),(float)f->pw/d->maxSize,(float)f->ph/d->maxSize);
+        glActiveTexture(GL_TEXTURE0); glBindVertexArray(vao); glDrawArrays(GL_TRIANGLE_STRIP,0,4);
+        glFinish();
+        uint64_t t1=traceNow();
+        render(f->w,f->h,f->mask!=0,&r);
+        glFinish();
+        uint64_t t2=traceNow();
+        upload.record(t1-t0); total.record(t2-t1); spent+=t2-t1;
+    }
+
+    logFlush();   // the pipeline's lines, formatted here rather than inside the timed frames
+    HistSnapshot a, b; a.add(total); b.add(upload);
+    auto ms=[](const HistSnapshot& x, double q){ return x.percentile(q)*1e-6; };
+    printf("render+finish: p50 %.3f p90 %.3f p99 %.3f max %.3f ms over %llu frames (%.1f fps)\n",
+        ms(a,0.5),ms(a,0.9),ms(a,0.99),a.max*1e-6,(unsigned long long)a.count,spent?a.count/(spent*1e-9):0.0);
+    printf("frame upload (not counted): p50 %.3f max %.3f ms\n",ms(b,0.5),b.max*1e-6);
+    printf("textures %.1f MB, %d levels, ring %d, capture %s\n",texBytes/1048576.0,levels,slots,
+        capture==CAP_BLIT?"blit":capture==CAP_RESOLVE?"resolve":"resolve+downscale");
+    eglMakeCurrent(dpy,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT);
+    eglTerminate(dpy);
+    return 0;
+}
@@ -0,0 +1,36 @@
+// mbstat: prints the live counters the mod publishes (see src/Stats.h).
+// usage: mbstat [stats file] [interval ms]
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Stats.h"
+
+int main(int argc, char** argv){
+    const char* path=argc>1?argv[1]:"/sdcard/games/com.mojang/motionblur.stats";
+    int ms=argc>2?atoi(argv[2]):1000;
+    int fd=open(path,O_RDONLY);
+    if(fd<0){ perror(path); return 1; }
+    void* p=mmap(0,sizeof(StatsFile),PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+    if(p==MAP_FAILED){ perror("mmap"); return 1; }
+    const StatsFile* f=(const StatsFile*)p;
+    if(memcmp(f->magic,"MBST",4) || f->version!=STATS_VERSION || f->size!=sizeof(StatsFile)){
+        fprintf(stderr,"%s: not a version %u stats file\n",path,STATS_VERSION); return 1;
+    }
+    for(unsigned seen=~0u;;usleep(ms*1000)){
+        if(f->stats.version()==seen) continue;   // nothing published since the last line
+        seen=f->stats.version();
+        Stats s=f->stats.load();
+        printf("%6.1f fps | capture %.3f blur %.3f draw %.3f ms | %dx%d scale %.2f game %.2f | levels %d ring %d turns %d | %.1f MB | %s%s%s%s%s | governor %d (%.0f C, battery %d%%) | %llu frames %llu skipped\n",
+            s.fps, s.passMs[0],s.passMs[1],s.passMs[2], s.width,s.height,s.scale,s.gameScale, s.levels,s.ring,s.turns,
+            s.textureBytes/1048576.0, s.capture,
+            s.flags&STATS_REDIRECT?" redirect":"", s.flags&STATS_CHECKERBOARD?" checkerboard":"",
+            s.flags&STATS_UI_MASK?" ui-mask":"", s.flags&STATS_TRACING?" tracing":"",
+            s.governor,s.temp,s.battery,
+            (unsigned long long)s.frames,(unsigned long long)s.skipped);
+        fflush(stdout);
+    }
+}